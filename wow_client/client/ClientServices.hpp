@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Network
+{
+    class EndpointResolver;
+}
+
+namespace Wow
+{
+    class LoginThrottle;
+    class LoginWorkerPool;
+    class RealmListRegistry;
+    class RealmSelector;
+    class SessionStore;
+
+    //! Fleet wide services shared by every bot, owned by the fleet and outliving all of its clients
+    struct ClientServices
+    {
+        LoginWorkerPool &               m_loginPool;
+        Network::EndpointResolver &     m_resolver;
+        RealmListRegistry &             m_realmLists;
+        RealmSelector &                 m_realmSelector;
+        SessionStore *                  m_sessionStore;     // optional
+        LoginThrottle *                 m_loginThrottle;    // optional
+
+        //! Queued outgoing bytes per connection before a send drops it
+        size_t                          m_sendHighWaterMark;
+    };
+}
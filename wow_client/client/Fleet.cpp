@@ -0,0 +1,247 @@
+#include "client/Fleet.hpp"
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace Wow
+{
+    std::vector< Account > LoadAccounts( const std::string & path )
+    {
+        std::vector< Account > accounts;
+
+        std::ifstream file( path );
+        if ( !file )
+        {
+            std::cerr << "[ERROR] Could not open accounts file: " << path << "\n";
+            return accounts;
+        }
+
+        std::string line;
+        while ( std::getline( file, line ) )
+        {
+            if ( !line.empty() && line.back() == '\r' )
+                line.pop_back();
+
+            if ( line.empty() || line.front() == '#' )
+                continue;
+
+            const auto pos = line.find( ':' );
+            if ( pos == std::string::npos || pos == 0 )
+            {
+                std::cerr << "[ERROR] Malformed account entry: " << line << "\n";
+                continue;
+            }
+
+            accounts.push_back( { line.substr( 0, pos ), line.substr( pos + 1 ) } );
+        }
+
+        return accounts;
+    }
+
+    Fleet::Fleet( const FleetOptions & options )
+        : m_options( options )
+        , m_loginPool( std::max< size_t >( options.m_shardsCount, 1u ) )
+        , m_realmSelector( m_resolver, options.m_realmSelector )
+    {
+        m_options.m_shardsCount = std::max< size_t >( m_options.m_shardsCount, 1u );
+    }
+
+    int Fleet::RunService( const std::vector< Account > & accounts )
+    {
+        if ( accounts.empty() )
+        {
+            std::cerr << "[ERROR] No accounts to run\n";
+            return EXIT_FAILURE;
+        }
+
+        auto & credentialCache = m_loginPool.GetCredentialCache();
+        if ( !m_options.m_credentialCachePath.empty() && credentialCache.Load( m_options.m_credentialCachePath ) )
+            std::cout << "[INFO] Loaded " << credentialCache.GetSize() << " cached credential(s)\n";
+
+        std::vector< std::pair< std::string_view, std::string_view > > identities;
+        identities.reserve( accounts.size() );
+
+        for ( const auto & account : accounts )
+            identities.emplace_back( account.m_username, account.m_password );
+
+        credentialCache.PrecomputeIdentities( identities );
+
+        //! every account owns the store slot at its index in the accounts list
+        if ( !m_options.m_sessionStorePath.empty() )
+            m_sessionStore.emplace( m_options.m_sessionStorePath, accounts.size(), m_options.m_sessionTtl );
+
+        //! the ramp starts with the run
+        if ( m_options.m_loginThrottle.m_loginsPerSecond > 0.0 )
+            m_loginThrottle.emplace( m_options.m_loginThrottle );
+
+        ClientServices services{ m_loginPool, m_resolver, m_realmLists, m_realmSelector, m_sessionStore && m_sessionStore->IsOpen() ? &*m_sessionStore : nullptr, m_loginThrottle ? &*m_loginThrottle : nullptr, m_options.m_sendHighWaterMark };
+
+        const size_t shardsCount = std::min( m_options.m_shardsCount, accounts.size() );
+        for ( size_t idx = 0u; idx < shardsCount; ++idx )
+            m_shards.push_back( std::make_unique< Shard >() );
+
+        for ( size_t idx = 0u; idx < accounts.size(); ++idx )
+        {
+            auto & shard = *m_shards[ idx % shardsCount ];
+            shard.m_clients.push_back( std::make_unique< GameClient >( shard.m_context, services, idx, m_options.m_realmlist, accounts[ idx ].m_username, accounts[ idx ].m_password ) );
+        }
+
+        std::cout << "[INFO] Running " << accounts.size() << " bot(s) on " << shardsCount << " shard(s)\n";
+
+        boost::asio::io_context context;
+        boost::asio::signal_set signals( context, SIGINT, SIGTERM );
+        signals.async_wait( [&]( auto, auto )
+        {
+            for ( auto & shard : m_shards )
+                shard->m_context.stop();
+        } );
+
+        boost::asio::steady_timer statsTimer( context );
+        ReportStats( statsTimer );
+
+        size_t runningShards = shardsCount;
+        for ( auto & shard : m_shards )
+        {
+            shard->m_thread = std::thread( [&, shard = shard.get()]
+            {
+                RunShard( *shard );
+                shard->m_running = false;
+
+                boost::asio::post( context, [&]
+                {
+                    if ( --runningShards == 0u )
+                    {
+                        signals.cancel();
+                        statsTimer.cancel();
+                    }
+                } );
+            } );
+        }
+
+        context.run();
+
+        for ( auto & shard : m_shards )
+        {
+            shard->m_context.stop();
+            shard->m_thread.join();
+        }
+
+        //! queued proofs still run and post their completion to the stopped shards, which drop it when they are destroyed below
+        m_loginPool.Shutdown();
+
+        m_shards.clear();
+        m_sessionStore.reset();
+        m_loginThrottle.reset();
+
+        if ( !m_options.m_credentialCachePath.empty() && !credentialCache.Save( m_options.m_credentialCachePath ) )
+            std::cerr << "[ERROR] Could not save credential cache: " << m_options.m_credentialCachePath << "\n";
+
+        return EXIT_SUCCESS;
+    }
+
+    void Fleet::ReportStats( boost::asio::steady_timer & timer )
+    {
+        timer.expires_after( STATS_INTERVAL );
+        timer.async_wait( [this, &timer]( const boost::system::error_code & error )
+        {
+            if ( error )
+                return;
+
+            std::cout << "[INFO] Logins: " << m_loginPool.GetCompletedCount() << " ( " << m_loginPool.SampleLoginsPerSecond() << " / sec )\n";
+            ReportSessionStats( timer.get_executor() );
+            ReportStats( timer );
+        } );
+    }
+
+    void Fleet::ReportSessionStats( boost::asio::any_io_executor executor )
+    {
+        struct SessionStats
+        {
+            size_t m_queueDepth = 0u;
+            size_t m_droppedPackets = 0u;
+#if defined( HEADLESSY_ALLOCATION_STATS )
+            size_t m_bufferedPackets = 0u;
+            uint64_t m_bufferedPacketAllocations = 0u;
+#endif
+        };
+
+        struct Totals
+        {
+            size_t m_pendingShards;
+            SessionStats m_stats;
+        };
+
+        //! a finished shard has no bots left to count, only the running ones are asked
+        std::vector< Shard * > runningShards;
+        for ( auto & shard : m_shards )
+        {
+            if ( shard->m_running )
+                runningShards.push_back( shard.get() );
+        }
+
+        if ( runningShards.empty() )
+            return;
+
+        auto totals = std::make_shared< Totals >( Totals{ runningShards.size(), {} } );
+
+        //! sessions belong to their shard thread, every shard sums its own bots and hands the result back to the stats thread.
+        //! A shard that finishes after it was asked never answers, only the line of that interval is skipped.
+        for ( auto * shard : runningShards )
+        {
+            boost::asio::post( shard->m_context, [executor, totals, shard]
+            {
+                SessionStats stats;
+                for ( auto & client : shard->m_clients )
+                {
+                    stats.m_queueDepth += client->GetQueueDepth();
+                    stats.m_droppedPackets += client->GetDroppedPacketsCount();
+#if defined( HEADLESSY_ALLOCATION_STATS )
+                    stats.m_bufferedPackets += client->GetBufferedPacketsCount();
+                    stats.m_bufferedPacketAllocations += client->GetBufferedPacketAllocations();
+#endif
+                }
+
+                boost::asio::post( executor, [totals, stats]
+                {
+                    totals->m_stats.m_queueDepth += stats.m_queueDepth;
+                    totals->m_stats.m_droppedPackets += stats.m_droppedPackets;
+#if defined( HEADLESSY_ALLOCATION_STATS )
+                    totals->m_stats.m_bufferedPackets += stats.m_bufferedPackets;
+                    totals->m_stats.m_bufferedPacketAllocations += stats.m_bufferedPacketAllocations;
+#endif
+
+                    if ( --totals->m_pendingShards != 0u )
+                        return;
+
+                    std::cout << "[INFO] Queued packets: " << totals->m_stats.m_queueDepth << ", dropped packets: " << totals->m_stats.m_droppedPackets << "\n";
+
+#if defined( HEADLESSY_ALLOCATION_STATS )
+                    //! the world receive path is meant to run without touching the heap, once the buffer pools are warm this stays at zero
+                    if ( totals->m_stats.m_bufferedPackets != 0u )
+                        std::cout << "[INFO] Allocations per buffered world packet: " << ( double )totals->m_stats.m_bufferedPacketAllocations / totals->m_stats.m_bufferedPackets << "\n";
+#endif
+                } );
+            } );
+        }
+    }
+
+    void Fleet::RunShard( Shard & shard )
+    {
+        size_t runningClients = shard.m_clients.size();
+
+        for ( auto & client : shard.m_clients )
+        {
+            client->Start( [&]
+            {
+                //! Last finished bot releases the shard, run() returns once the remaining sockets are closed
+                if ( --runningClients == 0u )
+                    shard.m_work.reset();
+            } );
+        }
+
+        shard.m_context.run();
+    }
+}
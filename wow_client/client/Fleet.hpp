@@ -0,0 +1,92 @@
+#pragma once
+
+#include "client/GameClient.hpp"
+#include "client/auth/LoginWorkerPool.hpp"
+#include "client/auth/RealmListRegistry.hpp"
+#include "client/LoginThrottle.hpp"
+#include "client/RealmSelector.hpp"
+#include "client/SessionStore.hpp"
+#include "networking/EndpointResolver.hpp"
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Wow
+{
+    struct Account
+    {
+        std::string m_username;
+        std::string m_password;
+    };
+
+    struct FleetOptions
+    {
+        std::string             m_realmlist;
+        size_t                  m_shardsCount = 1u;
+        std::string             m_credentialCachePath;      // optional
+        std::string             m_sessionStorePath;         // optional
+        std::chrono::seconds    m_sessionTtl = std::chrono::minutes( 15 );
+        LoginThrottleOptions    m_loginThrottle;
+        RealmSelectorOptions    m_realmSelector;
+        size_t                  m_sendHighWaterMark = 256 * 1024;
+    };
+
+    //! Reads `username:password` pairs, one per line, lines starting with '#' are skipped
+    std::vector< Account > LoadAccounts( const std::string & path );
+
+    //! Runs many bots in one process, bots are spread over shards and every shard owns
+    //! its own io_context driven by a single thread, so bots never share state across threads.
+    //! Bots are event driven: they only run when their sessions notify about new packets.
+    class Fleet
+    {
+    public:
+        static constexpr auto STATS_INTERVAL = std::chrono::seconds( 10 );
+
+        Fleet( const FleetOptions & options );
+
+        int                         RunService( const std::vector< Account > & accounts );
+
+    private:
+        struct Shard
+        {
+            using WorkGuard = boost::asio::executor_work_guard< boost::asio::io_context::executor_type >;
+
+            Shard()
+                : m_work( boost::asio::make_work_guard( m_context ) )
+                , m_running( true )
+            {
+            }
+
+            boost::asio::io_context                     m_context;
+            WorkGuard                                   m_work;
+
+            //! Cleared once run() returned, handlers posted to the shard after that never run
+            std::atomic< bool >                         m_running;
+
+            std::vector< std::unique_ptr< GameClient > > m_clients;
+            std::thread                                 m_thread;
+        };
+
+        void                        RunShard( Shard & shard );
+        void                        ReportStats( boost::asio::steady_timer & timer );
+        void                        ReportSessionStats( boost::asio::any_io_executor executor );
+
+        FleetOptions                                m_options;
+        LoginWorkerPool                             m_loginPool;
+        Network::EndpointResolver                   m_resolver;
+        RealmListRegistry                           m_realmLists;
+        RealmSelector                               m_realmSelector;
+        std::optional< SessionStore >               m_sessionStore;
+        std::optional< LoginThrottle >              m_loginThrottle;
+        std::vector< std::unique_ptr< Shard > >     m_shards;
+    };
+}
@@ -1,113 +1,222 @@
 #include "client/GameClient.hpp"
 #include "auth/AuthSession.hpp"
 #include "game/GameSession.hpp"
+#include "client/LoginThrottle.hpp"
+#include "client/RealmSelector.hpp"
+#include "client/SessionStore.hpp"
 
-#include <boost/asio/signal_set.hpp>
-#include <charconv>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/post.hpp>
 #include <iostream>
 
 namespace Wow
 {
-    constexpr uint16_t DEFAULT_REALM_PORT = 3724u;
+    GameClient::GameClient( boost::asio::io_context & context, ClientServices & services, size_t slot, const std::string & realmlist, const std::string & username, const std::string & password )
+        : m_context( context )
+        , m_services( services )
+        , m_slot( slot )
+        , m_logonServer( realmlist )
+        , m_username( username )
+        , m_password( password )
+        , m_updatePending( false )
+        , m_finished( false )
+    {
+        std::optional< StoredSession > session;
+        if ( m_services.m_sessionStore )
+            session = m_services.m_sessionStore->Load( m_slot, m_username );
+
+        //! CMSG_AUTH_SESSION can't carry the stored key yet, so a restored session goes through the logon reconnect
+        //! instead of straight to its realm, which still skips the SRP6 proof
+        auto & login = m_state.emplace< LoginState >( m_logonServer, m_username, m_password );
+        if ( session )
+            login.m_sessionKey = std::move( session->m_sessionKey );
+    }
 
-    static boost::asio::ip::tcp::endpoint ParseEndpoint( boost::asio::io_context & context, std::string_view address )
+    void GameClient::Start( FinishHandler handler )
     {
-        std::string partAddress = { address.data(), address.size() };
-        std::string partPort = std::to_string( DEFAULT_REALM_PORT );
+        m_finishHandler = std::move( handler );
+        Wake();
+    }
 
-        const auto pos = address.find_last_of( ":" );
-        if ( pos != std::string::npos )
-        {
-            partAddress = address.substr( 0, pos );
-            partPort = address.substr( pos + 1 );
-        }
+    size_t GameClient::GetQueueDepth() const
+    {
+        if ( auto * state = std::get_if< LoginState >( &m_state ); state && state->m_session )
+            return state->m_session->GetQueueDepth();
 
-        boost::asio::ip::tcp::resolver resolver( context );
-        boost::system::error_code ec{};
-        auto basic_result = resolver.resolve(partAddress, partPort, ec);
-        if ( basic_result.empty() )
-        {
-            std::cerr << "[ERROR] Could not resolve address: " << partAddress << ":" << partPort << "\n";
-            std::terminate();
-        }
+        if ( auto * state = std::get_if< GameState >( &m_state ); state && state->m_session )
+            return state->m_session->GetQueueDepth();
 
-        auto endpoint = basic_result.begin()->endpoint();
-        return endpoint;
+        return 0u;
     }
 
-    GameClient::GameClient()
-        : m_state( std::monostate{} )
+    size_t GameClient::GetDroppedPacketsCount() const
     {
+        if ( auto * state = std::get_if< GameState >( &m_state ); state && state->m_session )
+            return state->m_session->GetDroppedPacketsCount();
+
+        return 0u;
     }
 
-    int GameClient::RunService( const std::string & realmlist, const std::string & username, const std::string & password )
+#if defined( HEADLESSY_ALLOCATION_STATS )
+    size_t GameClient::GetBufferedPacketsCount() const
     {
-        std::thread thread( [&]
-        {
-            m_context.run();
-        } );
+        if ( auto * state = std::get_if< GameState >( &m_state ); state && state->m_session )
+            return state->m_session->GetBufferedPacketsCount();
+
+        return 0u;
+    }
+
+    uint64_t GameClient::GetBufferedPacketAllocations() const
+    {
+        if ( auto * state = std::get_if< GameState >( &m_state ); state && state->m_session )
+            return state->m_session->GetBufferedPacketAllocations();
 
-        boost::asio::signal_set signals( m_context, SIGINT, SIGTERM );
-        signals.async_wait( [&]( auto, auto )
+        return 0u;
+    }
+#endif
+
+    void GameClient::Wake()
+    {
+        if ( m_updatePending || m_finished )
+            return;
+
+        m_updatePending = true;
+        boost::asio::post( m_context, [this]
         {
-            m_context.stop();
+            m_updatePending = false;
+            Update();
         } );
+    }
 
-        auto logonEndpoint = ParseEndpoint( m_context, realmlist );
-        m_state.emplace< LoginState >( realmlist, username, password );
+    void GameClient::Update()
+    {
+        if ( m_finished )
+            return;
 
-        while ( !m_context.stopped() )
+        const bool result = std::visit( [&]( auto & state )
         {
-            const bool result = std::visit( [&]( auto & state )
-            {
-                if constexpr ( !std::is_same_v< std::monostate &, decltype( state ) > )
-                    return UpdateState( state );
+            if constexpr ( !std::is_same_v< std::monostate &, decltype( state ) > )
+                return UpdateState( state );
 
-                return true;
-            }, m_state );
+            return true;
+        }, m_state );
 
-            if ( !result )
-                break;
-        }
+        if ( result )
+            return;
+
+        //! a bot that gave up on the logon must not hand a stale session to the next run
+        if ( m_services.m_sessionStore && std::holds_alternative< LoginState >( m_state ) )
+            m_services.m_sessionStore->Invalidate( m_slot );
 
-        m_context.stop();
-        thread.join();
+        //! Dropping the sessions closes their sockets, so the shard can run out of work
+        m_finished = true;
+        m_state.emplace< std::monostate >();
 
-        return EXIT_SUCCESS;
+        if ( m_finishHandler )
+            m_finishHandler();
     }
 
     bool GameClient::UpdateState( LoginState & state )
     {
-        if ( !state.m_session )
+        //! the realm list is in, the bot waits for the fleet wide probe to pick its realm
+        if ( state.m_realmList )
         {
-            state.m_session.emplace( m_context );
+            if ( !state.m_selectedRealm )
+                return true;
 
-            auto endpoint = ParseEndpoint( m_context, state.m_logonServer );
-            if ( !state.m_session->Connect( endpoint, state.m_username, state.m_password ) )
+            const Auth::ServerRealmInfo * realm = *state.m_selectedRealm;
+            if ( !realm )
+            {
+                std::cerr << "[ERROR] No usable realm for " << m_username << "\n";
                 return false;
+            }
+
+            //! the realm lives in the snapshot, which has to outlive the state change
+            RealmListSnapshot realmlist = state.m_realmList;
+            auto cryptoKey = state.m_session->GetCredentials().K;
+
+            if ( m_services.m_sessionStore )
+                m_services.m_sessionStore->Save( m_slot, m_username, cryptoKey );
+
+            m_state.emplace< GameState >( std::string( realm->address ), std::move( cryptoKey ) );
+
+            Wake();
+            return true;
+        }
+
+        if ( !state.m_session && m_services.m_loginThrottle )
+        {
+            //! the timer only wakes the bot, the expiry check below decides whether the slot has come
+            if ( !state.m_admission )
+            {
+                state.m_admission.emplace( m_context, m_services.m_loginThrottle->Acquire() );
+                state.m_admission->async_wait( [this]( const boost::system::error_code & error )
+                {
+                    if ( !error )
+                        Wake();
+                } );
+            }
+
+            if ( state.m_admission->expiry() > boost::asio::steady_timer::clock_type::now() )
+                return true;
+        }
+
+        if ( !state.m_session )
+        {
+            state.m_session.emplace( m_context, m_services );
+            state.m_session->SetNotifyHandler( [this] { Wake(); } );
+            state.m_session->SetHighWaterMark( m_services.m_sendHighWaterMark );
+
+            if ( state.m_sessionKey )
+                state.m_session->Reconnect( state.m_logonServer, state.m_username, state.m_password, *state.m_sessionKey );
+            else
+                state.m_session->Connect( state.m_logonServer, state.m_username, state.m_password );
         }
 
         state.m_session->Update();
 
-        if ( auto realmlist = state.m_session->GetRealmList() )
+        if ( const auto & realmlist = state.m_session->GetRealmList() )
         {
-            std::cout << "\nRealmlist: \n";
-            for ( auto & info : *realmlist )
+            state.m_realmList = realmlist;
+
+            //! the state can't change until a realm is selected, so the coroutine finds it still in place
+            boost::asio::co_spawn( m_context, [this, realmlist]() -> boost::asio::awaitable< void >
             {
-                std::cout << " - " << info.name << " (" << info.address << ")\n";
-            }
+                const auto * realm = co_await m_services.m_realmSelector.SelectAsync( realmlist, m_slot );
 
-            if ( realmlist->empty() )
-                return false;
+                if ( auto * state = std::get_if< LoginState >( &m_state ) )
+                    state->m_selectedRealm = realm;
 
-            auto & realm = realmlist->front();
-            auto cryptoKey = state.m_session->GetCredentials().K;
+                Wake();
+            }, boost::asio::detached );
 
-            m_state.emplace< GameState >( realm.address, cryptoKey );
             return true;
         }
 
-        return state.m_session->IsConnected();
+        if ( state.m_session->IsConnecting() || state.m_session->IsConnected() )
+            return true;
+
+        //! an authenticated connection dropped before the realm list arrived, its key is still valid on the server,
+        //! a rejected reconnect falls back to the full SRP6 logon. Reconnects count as attempts too, so a server
+        //! that keeps dropping authenticated connections can't hold the bot in a loop
+        if ( state.m_session->IsAuthenticated() )
+        {
+            state.m_sessionKey = state.m_session->GetCredentials().K;
+        }
+        else
+        {
+            state.m_sessionKey.reset();
+        }
+
+        if ( ++state.m_attempts >= LoginState::MAX_LOGON_ATTEMPTS )
+            return false;
+
+        state.m_session.reset();
+        state.m_admission.reset();
+
+        Wake();
+        return true;
     }
 
     bool GameClient::UpdateState( GameState & state )
@@ -115,14 +224,13 @@ namespace Wow
         if ( !state.m_session )
         {
             state.m_session.emplace( m_context, state.m_cryptoKey );
-
-            auto endpoint = ParseEndpoint( m_context, state.m_realmServer );
-            if ( !state.m_session->Connect( endpoint ) )
-                return false;
+            state.m_session->SetNotifyHandler( [this] { Wake(); } );
+            state.m_session->SetHighWaterMark( m_services.m_sendHighWaterMark );
+            state.m_session->Connect( m_services.m_resolver, state.m_realmServer );
         }
 
         state.m_session->Update();
 
-        return state.m_session->IsConnected();
+        return state.m_session->IsConnecting() || state.m_session->IsConnected();
     }
 }
@@ -2,9 +2,13 @@
 
 #include "auth/AuthSession.hpp"
 #include "game/GameSession.hpp"
+#include "auth/LoginWorkerPool.hpp"
+#include "client/ClientServices.hpp"
 
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
 
+#include <functional>
 #include <variant>
 #include <optional>
 
@@ -12,10 +16,14 @@ namespace Wow
 {
     struct LoginState
     {
+        //! Logon connections, reconnects included, that may end before the realm list arrives until the bot gives up
+        static constexpr uint32_t MAX_LOGON_ATTEMPTS = 3;
+
         LoginState( const std::string & realmlist, const std::string & username, const std::string & password )
             : m_username( username )
             , m_password( password )
             , m_logonServer( realmlist )
+            , m_attempts( 0u )
         {
         }
 
@@ -23,13 +31,24 @@ namespace Wow
         std::string m_username;
         std::string m_password;
 
+        //! Key of the last successful logon, a dropped connection re-authenticates with it
+        std::optional< Crypto::BigNumber > m_sessionKey;
+        uint32_t                           m_attempts;
+
+        //! Expires when the login throttle admits the next connection
+        std::optional< boost::asio::steady_timer > m_admission;
+
+        //! Set once the realm list arrived, the selected realm is null when none is usable
+        RealmListSnapshot                                   m_realmList;
+        std::optional< const Auth::ServerRealmInfo * >      m_selectedRealm;
+
         std::optional< AuthSession > m_session;
     };
 
     struct GameState
     {
-        GameState( const std::string & realmlist, const Crypto::BigNumber & key )
-            : m_cryptoKey( key )
+        GameState( const std::string & realmlist, Crypto::BigNumber key )
+            : m_cryptoKey( std::move( key ) )
             , m_realmServer( realmlist )
         {
         }
@@ -42,15 +61,42 @@ namespace Wow
     class GameClient
     {
     public:
-        GameClient();
+        using FinishHandler = std::function< void() >;
 
-        int                         RunService( const std::string & realmlist, const std::string & username, const std::string & password );
+        //! `slot` is the index of the account in the session store
+        GameClient( boost::asio::io_context & context, ClientServices & services, size_t slot, const std::string & realmlist, const std::string & username, const std::string & password );
+
+        //! Schedules the first update, `handler` is invoked on the client thread once the bot has finished
+        void                        Start( FinishHandler handler );
+        bool                        IsFinished() const { return m_finished; }
+
+        //! Gauges of the current sessions, only valid on the client thread
+        size_t                      GetQueueDepth() const;
+        size_t                      GetDroppedPacketsCount() const;
+
+#if defined( HEADLESSY_ALLOCATION_STATS )
+        //! World packets read without waiting and the allocations their dispatch took, see Network::Socket
+        size_t                      GetBufferedPacketsCount() const;
+        uint64_t                    GetBufferedPacketAllocations() const;
+#endif
 
     private:
+        //! Requests an update on the client thread, multiple wake ups before it runs are coalesced
+        void                        Wake();
+        void                        Update();
+
         bool                        UpdateState( LoginState & state );
         bool                        UpdateState( GameState & session );
 
-        boost::asio::io_context                                 m_context;
+        boost::asio::io_context &                               m_context;
+        ClientServices &                                        m_services;
+        size_t                                                  m_slot;
+        std::string                                             m_logonServer;
+        std::string                                             m_username;
+        std::string                                             m_password;
         std::variant< std::monostate, LoginState, GameState >   m_state;
+        FinishHandler                                           m_finishHandler;
+        bool                                                    m_updatePending;
+        bool                                                    m_finished;
     };
 }
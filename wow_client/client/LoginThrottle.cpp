@@ -0,0 +1,80 @@
+#include "client/LoginThrottle.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace Wow
+{
+    bool ParseRampProfile( std::string_view name, RampProfile & profile )
+    {
+        if ( name == "linear" )
+            profile = RampProfile::Linear;
+        else if ( name == "step" )
+            profile = RampProfile::Step;
+        else if ( name == "spike" )
+            profile = RampProfile::Spike;
+        else
+            return false;
+
+        return true;
+    }
+
+    LoginThrottle::LoginThrottle( const LoginThrottleOptions & options )
+        : m_options( options )
+        , m_start( Clock::now() )
+        , m_nextSlot( 0 )
+    {
+        m_options.m_burst = std::max( m_options.m_burst, 1u );
+        m_options.m_rampSteps = std::max( m_options.m_rampSteps, 1u );
+
+        //! spike starts with a full bucket, the other profiles start empty and fill while ramping
+        if ( m_options.m_ramp == RampProfile::Spike )
+            m_nextSlot = -( int64_t )( m_options.m_burst - 1u ) * GetInterval( 0 );
+    }
+
+    std::chrono::nanoseconds LoginThrottle::Acquire()
+    {
+        const int64_t now = std::chrono::duration_cast< std::chrono::nanoseconds >( Clock::now() - m_start ).count();
+
+        int64_t slot = 0;
+        int64_t nextSlot = m_nextSlot.load( std::memory_order_relaxed );
+        do
+        {
+            //! an idle throttle refills up to the burst, never more
+            slot = std::max( nextSlot, now - ( int64_t )( m_options.m_burst - 1u ) * GetInterval( now ) );
+        }
+        while ( !m_nextSlot.compare_exchange_weak( nextSlot, slot + GetInterval( slot ), std::memory_order_relaxed ) );
+
+        int64_t delay = std::max< int64_t >( slot - now, 0 );
+
+        if ( m_options.m_jitter.count() > 0 )
+        {
+            thread_local std::mt19937_64 generator{ std::random_device{}() };
+
+            const int64_t jitter = std::chrono::duration_cast< std::chrono::nanoseconds >( m_options.m_jitter ).count();
+            delay += std::uniform_int_distribution< int64_t >( 0, jitter )( generator );
+        }
+
+        return std::chrono::nanoseconds( delay );
+    }
+
+    double LoginThrottle::GetRate( int64_t elapsed ) const
+    {
+        const int64_t rampTime = std::chrono::duration_cast< std::chrono::nanoseconds >( m_options.m_rampTime ).count();
+        if ( m_options.m_ramp == RampProfile::Spike || rampTime <= 0 || elapsed >= rampTime )
+            return m_options.m_loginsPerSecond;
+
+        double progress = std::max< double >( elapsed, 0.0 ) / rampTime;
+        if ( m_options.m_ramp == RampProfile::Step )
+            progress = std::floor( progress * m_options.m_rampSteps + 1.0 ) / m_options.m_rampSteps;
+
+        //! the floor only keeps an early ramp from stalling, it never exceeds the configured rate
+        return std::max( m_options.m_loginsPerSecond * progress, std::min( m_options.m_loginsPerSecond, MIN_LOGINS_PER_SECOND ) );
+    }
+
+    int64_t LoginThrottle::GetInterval( int64_t elapsed ) const
+    {
+        return ( int64_t )( 1'000'000'000.0 / GetRate( elapsed ) );
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string_view>
+
+namespace Wow
+{
+    enum class RampProfile
+    {
+        Linear,     // rate grows evenly from zero to the target over the ramp time
+        Step,       // rate grows in equal steps over the ramp time
+        Spike       // target rate from the start and the whole burst is available at once
+    };
+
+    bool ParseRampProfile( std::string_view name, RampProfile & profile );
+
+    struct LoginThrottleOptions
+    {
+        double                      m_loginsPerSecond = 0.0;    // zero disables the throttle
+        uint32_t                    m_burst = 1u;
+        std::chrono::milliseconds   m_jitter{ 0 };
+        RampProfile                 m_ramp = RampProfile::Linear;
+        std::chrono::seconds        m_rampTime{ 0 };
+        uint32_t                    m_rampSteps = 4u;
+    };
+
+    //! Fleet wide admission control for logon connections, a GCRA token bucket whose rate follows the ramp profile.
+    //! Every login reserves the next free slot with a single CAS, so shards never wait on each other.
+    class LoginThrottle
+    {
+    public:
+        //! Lowest rate while ramping up, or the target rate when that is lower
+        static constexpr double MIN_LOGINS_PER_SECOND = 1.0;
+
+        //! `options.m_loginsPerSecond` must be positive
+        LoginThrottle( const LoginThrottleOptions & options );
+
+        //! Reserves an admission slot and returns how long the caller has to wait for it, jitter included
+        std::chrono::nanoseconds    Acquire();
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        double                      GetRate( int64_t elapsed ) const;
+        int64_t                     GetInterval( int64_t elapsed ) const;
+
+        LoginThrottleOptions        m_options;
+        Clock::time_point           m_start;
+
+        //! theoretical arrival time of the next login in nanoseconds since `m_start`
+        std::atomic< int64_t >      m_nextSlot;
+    };
+}
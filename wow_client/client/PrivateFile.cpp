@@ -0,0 +1,47 @@
+#include "client/PrivateFile.hpp"
+
+#if defined( _WIN32 )
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #include <sddl.h>
+#else
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace Wow
+{
+    bool CreatePrivateFile( const std::string & path )
+    {
+#if defined( _WIN32 )
+        //! security attributes only apply to a newly created file
+        DeleteFileA( path.c_str() );
+
+        //! protected DACL with a single entry, full access for the owner and nothing inherited from the directory
+        PSECURITY_DESCRIPTOR descriptor = nullptr;
+        if ( !ConvertStringSecurityDescriptorToSecurityDescriptorA( "D:P(A;;FA;;;OW)", SDDL_REVISION_1, &descriptor, nullptr ) )
+            return false;
+
+        SECURITY_ATTRIBUTES attributes{ sizeof( attributes ), descriptor, FALSE };
+        const HANDLE file = CreateFileA( path.c_str(), GENERIC_WRITE, 0, &attributes, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr );
+        LocalFree( descriptor );
+
+        if ( file == INVALID_HANDLE_VALUE )
+            return false;
+
+        CloseHandle( file );
+        return true;
+#else
+        //! O_EXCL after the unlink, a link planted at the path is never followed
+        ::unlink( path.c_str() );
+
+        const int file = ::open( path.c_str(), O_WRONLY | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR );
+        if ( file < 0 )
+            return false;
+
+        ::close( file );
+        return true;
+#endif
+    }
+}
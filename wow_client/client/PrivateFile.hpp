@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string>
+
+namespace Wow
+{
+    //! Creates an empty file only the current user can read and write, an existing file is replaced.
+    //! Writing it afterwards through a truncating stream keeps the restricted permissions.
+    bool CreatePrivateFile( const std::string & path );
+}
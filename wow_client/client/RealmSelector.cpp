@@ -0,0 +1,239 @@
+#include "client/RealmSelector.hpp"
+#include "client/game/GameSession.hpp"
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace Wow
+{
+    RealmSelector::RealmSelector( Network::EndpointResolver & resolver, const RealmSelectorOptions & options )
+        : m_resolver( resolver )
+        , m_options( options )
+    {
+    }
+
+    boost::asio::awaitable< const Auth::ServerRealmInfo * > RealmSelector::SelectAsync( RealmListSnapshot realmList, size_t slot )
+    {
+        std::shared_ptr< Ranking > ranking;
+        bool isRanking = false;
+        {
+            std::lock_guard lock( m_mutex );
+
+            const auto now = Clock::now();
+            std::erase_if( m_rankings, [&]( const auto & entry )
+            {
+                return entry.second->m_expiry <= now;
+            } );
+
+            //! the first bot of a realm set probes, everybody else waits for its ranking.
+            //! Lists with the same key hold the same realms and populations in the same order, so the indices
+            //! and the scores stay valid for every bot that received it.
+            auto & entry = m_rankings[ realmList->m_key ];
+            isRanking = entry != nullptr;
+
+            if ( !entry )
+            {
+                entry = std::make_shared< Ranking >();
+                entry->m_expiry = Clock::time_point::max();
+            }
+
+            ranking = entry;
+        }
+
+        if ( isRanking )
+        {
+            co_await ranking->m_done.WaitAsync();
+        }
+        else
+        {
+            //! the bots of other shards wait on this one, a frame destroyed with its stopped shard still has to wake them
+            struct PublishGuard
+            {
+                ~PublishGuard()
+                {
+                    if ( m_ranking )
+                        m_selector.Publish( m_ranking, false );
+                }
+
+                RealmSelector &             m_selector;
+                std::shared_ptr< Ranking >  m_ranking;
+            } guard{ *this, ranking };
+
+            co_await RankAsync( realmList, *ranking );
+
+            guard.m_ranking.reset();
+            Publish( ranking, true );
+        }
+
+        if ( ranking->m_realms.empty() )
+            co_return nullptr;
+
+        co_return &realmList->m_realms[ Pick( *ranking, slot ) ];
+    }
+
+    void RealmSelector::Publish( const std::shared_ptr< Ranking > & ranking, bool isRanked )
+    {
+        {
+            std::lock_guard lock( m_mutex );
+
+            if ( isRanked )
+            {
+                ranking->m_expiry = Clock::now() + m_options.m_probeTtl;
+            }
+            else
+            {
+                std::erase_if( m_rankings, [&]( const auto & entry )
+                {
+                    return entry.second == ranking;
+                } );
+            }
+        }
+
+        ranking->m_done.Set();
+    }
+
+    boost::asio::awaitable< void > RealmSelector::RankAsync( RealmListSnapshot realmList, Ranking & ranking )
+    {
+        struct Candidate
+        {
+            size_t                                      m_index;
+            std::optional< std::chrono::nanoseconds >   m_rtt;
+            double                                      m_score;
+        };
+
+        //! owned by the probes as well, they may outlive this frame when its shard stops mid ranking
+        struct ProbeState
+        {
+            RealmListSnapshot           m_realmList;
+            std::vector< Candidate >    m_candidates;
+            size_t                      m_remaining = 0u;
+            Network::CompletionSignal   m_done;
+        };
+
+        auto state = std::make_shared< ProbeState >();
+        state->m_realmList = realmList;
+
+        auto & candidates = state->m_candidates;
+        for ( size_t idx = 0u; idx < realmList->m_realms.size(); ++idx )
+        {
+            if ( IsSelectable( realmList->m_realms[ idx ] ) )
+                candidates.push_back( { idx, std::nullopt, 0.0 } );
+        }
+
+        //! every probe runs in its own coroutine, the last one to finish wakes us up
+        if ( !candidates.empty() )
+        {
+            auto executor = co_await boost::asio::this_coro::executor;
+
+            state->m_remaining = candidates.size();
+
+            for ( size_t idx = 0u; idx < candidates.size(); ++idx )
+            {
+                boost::asio::co_spawn( executor, [this, state, idx]() -> boost::asio::awaitable< void >
+                {
+                    auto & candidate = state->m_candidates[ idx ];
+                    candidate.m_rtt = co_await ProbeAsync( state->m_realmList->m_realms[ candidate.m_index ].address );
+
+                    if ( --state->m_remaining == 0u )
+                        state->m_done.Set();
+                }, boost::asio::detached );
+            }
+
+            co_await state->m_done.WaitAsync();
+        }
+
+        std::erase_if( candidates, []( const Candidate & candidate )
+        {
+            return !candidate.m_rtt;
+        } );
+
+        for ( auto & candidate : candidates )
+        {
+            const double latency = std::chrono::duration< double, std::milli >( *candidate.m_rtt ).count();
+            const auto & realm = realmList->m_realms[ candidate.m_index ];
+
+            //! the population of the list being ranked, which is the one the waiting bots received
+            candidate.m_score = m_options.m_latencyWeight * latency + m_options.m_populationWeight * realm.populationLevel;
+        }
+
+        std::sort( candidates.begin(), candidates.end(), []( const Candidate & lhs, const Candidate & rhs )
+        {
+            return lhs.m_score < rhs.m_score;
+        } );
+
+        //! spreading weight is the inverse of the score, so a realm twice as good gets twice the bots
+        double total = 0.0;
+        for ( auto & candidate : candidates )
+        {
+            ranking.m_realms.push_back( candidate.m_index );
+            ranking.m_weights.push_back( total += 1.0 / std::max( candidate.m_score, 1.0 ) );
+        }
+
+        for ( auto & weight : ranking.m_weights )
+            weight /= total;
+
+        std::cout << "[INFO] Ranked " << ranking.m_realms.size() << " of " << realmList->m_realms.size() << " realm(s) ( version " << realmList->m_version << " )\n";
+    }
+
+    boost::asio::awaitable< std::optional< std::chrono::nanoseconds > > RealmSelector::ProbeAsync( std::string_view address )
+    {
+        auto [error, endpoints] = co_await m_resolver.ResolveAsync( address, DEFAULT_WORLD_PORT );
+        if ( error )
+            co_return std::nullopt;
+
+        auto executor = co_await boost::asio::this_coro::executor;
+
+        //! the timer closes the socket, which aborts a connect that takes too long
+        auto socket = std::make_shared< boost::asio::ip::tcp::socket >( executor );
+        auto timer = std::make_shared< boost::asio::steady_timer >( executor, PROBE_TIMEOUT );
+        timer->async_wait( [socket]( const boost::system::error_code & error )
+        {
+            if ( !error )
+                socket->close();
+        } );
+
+        const auto start = Clock::now();
+        co_await boost::asio::async_connect( *socket, endpoints, boost::asio::redirect_error( boost::asio::use_awaitable, error ) );
+        const auto rtt = Clock::now() - start;
+
+        timer->cancel();
+
+        if ( error )
+            co_return std::nullopt;
+
+        co_return rtt;
+    }
+
+    bool RealmSelector::IsSelectable( const Auth::ServerRealmInfo & realm ) const
+    {
+        constexpr int excludedFlags = ( int )Auth::RealmFlags::Offline | ( int )Auth::RealmFlags::Full | ( int )Auth::RealmFlags::VersionMismatch;
+        if ( ( int )realm.flags & excludedFlags )
+            return false;
+
+        return m_options.m_realmName.empty() || realm.name == m_options.m_realmName;
+    }
+
+    size_t RealmSelector::Pick( const Ranking & ranking, size_t slot ) const
+    {
+        if ( !m_options.m_spread )
+            return ranking.m_realms.front();
+
+        //! golden ratio sequence, consecutive slots land evenly spread over the cumulative weights
+        double position = std::fmod( slot * 0.6180339887498949, 1.0 );
+
+        auto itr = std::upper_bound( ranking.m_weights.begin(), ranking.m_weights.end(), position );
+        if ( itr == ranking.m_weights.end() )
+            --itr;
+
+        return ranking.m_realms[ std::distance( ranking.m_weights.begin(), itr ) ];
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "client/auth/RealmListRegistry.hpp"
+#include "networking/CompletionSignal.hpp"
+#include "networking/EndpointResolver.hpp"
+
+#include <boost/asio/awaitable.hpp>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Wow
+{
+    struct RealmSelectorOptions
+    {
+        std::string             m_realmName;                // optional, only realms with this name are picked
+        double                  m_latencyWeight = 1.0;      // score per millisecond of connect time
+        double                  m_populationWeight = 10.0;  // score per population level
+        bool                    m_spread = false;           // spread bots over all ranked realms instead of the best one
+        std::chrono::seconds    m_probeTtl{ 60 };
+    };
+
+    //! Ranks the realms of a realm list by probing their addresses in parallel. A set of realms is probed once
+    //! for the whole fleet, whichever account or logon server it came from, and its ranking reused until the ttl runs out.
+    //! The population is part of the set, so a changed load is ranked anew instead of waiting for the ttl.
+    //! Lower scores are better, offline, full and mismatching realms are never picked.
+    class RealmSelector
+    {
+    public:
+        static constexpr auto PROBE_TIMEOUT = std::chrono::seconds( 2 );
+
+        RealmSelector( Network::EndpointResolver & resolver, const RealmSelectorOptions & options );
+
+        //! Returns nullptr when no realm is usable, `slot` places the bot when spreading
+        boost::asio::awaitable< const Auth::ServerRealmInfo * > SelectAsync( RealmListSnapshot realmList, size_t slot );
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Ranking
+        {
+            std::vector< size_t >       m_realms;       // indices into the realm list, best first
+            std::vector< double >       m_weights;      // cumulative and normalized, for spreading
+            Clock::time_point           m_expiry;
+            Network::CompletionSignal   m_done;
+        };
+
+        boost::asio::awaitable< void >                                      RankAsync( RealmListSnapshot realmList, Ranking & ranking );
+        boost::asio::awaitable< std::optional< std::chrono::nanoseconds > > ProbeAsync( std::string_view address );
+
+        //! Wakes the waiting bots, an unranked set is dropped so the next bot probes it again
+        void                    Publish( const std::shared_ptr< Ranking > & ranking, bool isRanked );
+
+        bool                    IsSelectable( const Auth::ServerRealmInfo & realm ) const;
+        size_t                  Pick( const Ranking & ranking, size_t slot ) const;
+
+        Network::EndpointResolver &                                     m_resolver;
+        RealmSelectorOptions                                            m_options;
+        std::mutex                                                      m_mutex;
+        std::unordered_map< std::string, std::shared_ptr< Ranking > >   m_rankings;     // by realm list key
+    };
+}
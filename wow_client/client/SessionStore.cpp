@@ -0,0 +1,126 @@
+#include "client/SessionStore.hpp"
+#include "client/PrivateFile.hpp"
+
+#include <boost/interprocess/exceptions.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace Wow
+{
+    static int64_t GetTimestamp()
+    {
+        return std::chrono::duration_cast< std::chrono::seconds >( std::chrono::system_clock::now().time_since_epoch() ).count();
+    }
+
+    template< size_t N >
+    static void CopyString( char ( &destination )[ N ], std::string_view source )
+    {
+        const size_t length = std::min( source.size(), N - 1 );
+        std::memcpy( destination, source.data(), length );
+        std::memset( destination + length, 0, N - length );
+    }
+
+    SessionStore::SessionStore( const std::string & path, size_t slotsCount, std::chrono::seconds ttl )
+        : m_slotsCount( slotsCount )
+        , m_ttl( ttl )
+        , m_slots( nullptr )
+    {
+        const size_t fileSize = sizeof( FileHeader ) + slotsCount * sizeof( SessionRecord );
+
+        //! a file made for a different accounts list can't be trusted, start over with empty slots
+        std::error_code error;
+        bool isValid = std::filesystem::file_size( path, error ) == fileSize;
+        if ( isValid )
+        {
+            FileHeader header{};
+            std::ifstream file( path, std::ios::binary );
+            file.read( ( char* )&header, sizeof( header ) );
+
+            isValid = file && header.m_magic == FILE_MAGIC && header.m_slotsCount == slotsCount;
+        }
+
+        if ( !isValid )
+        {
+            //! a write to the stream fails when the file could not be created, which is reported below
+            std::ofstream file;
+            if ( CreatePrivateFile( path ) )
+                file.open( path, std::ios::binary | std::ios::trunc );
+
+            const FileHeader header{ FILE_MAGIC, ( uint32_t )slotsCount };
+            file.write( ( const char* )&header, sizeof( header ) );
+            file.close();
+
+            std::filesystem::resize_file( path, fileSize, error );
+            if ( !file || error )
+            {
+                std::cerr << "[ERROR] Could not create session store: " << path << "\n";
+                return;
+            }
+        }
+
+        try
+        {
+            m_file = boost::interprocess::file_mapping( path.c_str(), boost::interprocess::read_write );
+            m_region = boost::interprocess::mapped_region( m_file, boost::interprocess::read_write );
+        }
+        catch ( const boost::interprocess::interprocess_exception & exception )
+        {
+            std::cerr << "[ERROR] Could not map session store: " << path << " ( " << exception.what() << " )\n";
+            return;
+        }
+
+        m_slots = reinterpret_cast< SessionRecord * >( static_cast< std::byte * >( m_region.get_address() ) + sizeof( FileHeader ) );
+    }
+
+    SessionStore::~SessionStore()
+    {
+        if ( IsOpen() )
+            m_region.flush();
+    }
+
+    std::optional< StoredSession > SessionStore::Load( size_t slot, std::string_view username ) const
+    {
+        if ( !IsOpen() || slot >= m_slotsCount )
+            return std::nullopt;
+
+        const SessionRecord & record = m_slots[ slot ];
+        if ( record.m_timestamp == 0 || GetTimestamp() - record.m_timestamp >= m_ttl.count() )
+            return std::nullopt;
+
+        const std::string_view storedUsername( record.m_username, strnlen( record.m_username, MAX_USERNAME_LENGTH ) );
+        if ( storedUsername != username )
+            return std::nullopt;
+
+        StoredSession session;
+        session.m_sessionKey = Crypto::BigNumber( record.m_sessionKey );
+
+        return session;
+    }
+
+    void SessionStore::Save( size_t slot, std::string_view username, const Crypto::BigNumber & sessionKey )
+    {
+        if ( !IsOpen() || slot >= m_slotsCount )
+            return;
+
+        if ( username.size() >= MAX_USERNAME_LENGTH )
+            return Invalidate( slot );
+
+        SessionRecord & record = m_slots[ slot ];
+        CopyString( record.m_username, username );
+        if ( !sessionKey.ToBytes( record.m_sessionKey ) )
+            return Invalidate( slot );
+
+        record.m_timestamp = GetTimestamp();
+    }
+
+    void SessionStore::Invalidate( size_t slot )
+    {
+        if ( !IsOpen() || slot >= m_slotsCount )
+            return;
+
+        m_slots[ slot ].m_timestamp = 0;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "crypto/BigNumber.hpp"
+#include "client/packets/Packets.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace Wow
+{
+    struct StoredSession
+    {
+        Crypto::BigNumber   m_sessionKey;
+    };
+
+    //! Memory mapped file with one fixed slot per account, slots are assigned by the fleet up front
+    //! so every slot is only ever touched by the shard thread of its bot and needs no locking.
+    //! A restarted fleet re-authenticates still valid sessions through the logon reconnect instead of running the whole SRP6 logon.
+    //! The session keys log in as the account until they expire, the file is created readable by the current user only.
+    class SessionStore
+    {
+    public:
+        static constexpr uint32_t FILE_MAGIC = 'WSS2';
+        static constexpr size_t MAX_USERNAME_LENGTH = 32;
+
+        SessionStore( const std::string & path, size_t slotsCount, std::chrono::seconds ttl );
+        ~SessionStore();
+
+        bool                            IsOpen() const { return m_slots != nullptr; }
+
+        //! Returns the session kept in the slot if it belongs to `username` and is younger than the ttl
+        std::optional< StoredSession >  Load( size_t slot, std::string_view username ) const;
+        void                            Save( size_t slot, std::string_view username, const Crypto::BigNumber & sessionKey );
+        void                            Invalidate( size_t slot );
+
+    private:
+        struct FileHeader
+        {
+            uint32_t            m_magic;
+            uint32_t            m_slotsCount;
+        };
+
+        struct SessionRecord
+        {
+            //! seconds since epoch, zero marks an empty slot
+            int64_t             m_timestamp;
+            char                m_username[ MAX_USERNAME_LENGTH ];
+            FixedArray< 40 >    m_sessionKey;
+        };
+
+        size_t                                  m_slotsCount;
+        std::chrono::seconds                    m_ttl;
+        boost::interprocess::file_mapping       m_file;
+        boost::interprocess::mapped_region      m_region;
+        SessionRecord *                         m_slots;
+    };
+}
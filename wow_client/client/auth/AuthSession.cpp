@@ -1,4 +1,6 @@
 #include "AuthSession.hpp"
+#include "LoginWorkerPool.hpp"
+#include "client/ClientServices.hpp"
 
 #include "crypto/BigNumber.hpp"
 #include "crypto/Sha1.hpp"
@@ -6,17 +8,27 @@
 
 #include <boost/asio/ip/address.hpp>
 #include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
 #include <optional>
 #include <iostream>
 #include <gsl/span>
-#include <mutex>
 
 namespace Wow
 {
-    AuthSession::AuthSession( boost::asio::io_context & context )
+    static Network::ByteBuffer BuildChallenge( Auth::ClientOpcode opcode, std::string_view username, uint32_t localAddress )
+    {
+        return Auth::ClientLogonChallengeSchema::Build( { opcode, CLIENT_VERSION_MAJOR, CLIENT_VERSION_MINOR, CLIENT_VERSION_PATCH, CLIENT_BUILD_NUMBER, localAddress, username } );
+    }
+
+    AuthSession::AuthSession( boost::asio::io_context & context, ClientServices & services )
         : Socket( context )
+        , m_services( services )
+        , m_isReconnect( false )
         , m_credentials{}
+        , m_authenticated( false )
     {
+        //! a lost logon packet would stall the handshake forever, dropping the connection lets the owner retry
+        SetHighWaterPolicy( Network::HighWaterPolicy::Disconnect );
     }
 
     boost::asio::awaitable<bool> AuthSession::ReceivePacketAsync( Auth::ServerOpcode opcode )
@@ -25,182 +37,171 @@ namespace Wow
         switch ( opcode )
         {
             case Auth::ServerOpcode::LogonChallenge: co_return co_await ReceiveServerLogonChallengeAsync();
-            case Auth::ServerOpcode::LogonProof:     co_return co_await ReceiveServerLogonProofAsync();
-            case Auth::ServerOpcode::RealmList:      co_return co_await ReceiveServerRealmListAsync();
+            case Auth::ServerOpcode::LogonProof:         co_return co_await ReceiveServerLogonProofAsync();
+            case Auth::ServerOpcode::ReconnectChallenge: co_return co_await ReceiveServerReconnectChallengeAsync();
+            case Auth::ServerOpcode::ReconnectProof:     co_return co_await ReceiveServerReconnectProofAsync();
+            case Auth::ServerOpcode::RealmList:          co_return co_await ReceiveServerRealmListAsync();
         }
 
         co_return false;
     }
 
-    bool AuthSession::Connect( Endpoint endpoint, std::string_view username, std::string_view password )
+    void AuthSession::Connect( const std::string & address, std::string_view username, std::string_view password )
     {
-        const auto error = Socket::Connect( endpoint );
-        if ( error )
-        {
-            std::cerr << "[ERROR] " << error << "\n";
-            return false;
-        }
+        m_logonServer = address;
+        m_credentials.m_username = username;
+        m_credentials.m_password = password;
+        m_isReconnect = false;
+
+        ConnectAsync( m_services.m_resolver, address, DEFAULT_LOGON_PORT );
+    }
 
+    void AuthSession::Reconnect( const std::string & address, std::string_view username, std::string_view password, Crypto::BigNumber sessionKey )
+    {
+        m_logonServer = address;
         m_credentials.m_username = username;
         m_credentials.m_password = password;
+        m_credentials.K = std::move( sessionKey );
+        m_isReconnect = true;
 
-        SendLogonChallenge();
-        return true;
+        ConnectAsync( m_services.m_resolver, address, DEFAULT_LOGON_PORT );
+    }
+
+    void AuthSession::OnConnected()
+    {
+        if ( m_isReconnect )
+            SendReconnectChallenge();
+        else
+            SendLogonChallenge();
     }
 
     void AuthSession::Update()
     {
-        std::lock_guard lock( m_mutex );
-        while ( !m_queue.empty() )
+        m_queue.Drain( [this]( SessionPacket & packet )
         {
             std::visit( [this]( auto & p )
             {
                 HandlePacket( p );
-            }, m_queue.front() );
-            m_queue.pop_front();
-        }
+            }, packet );
+        } );
+    }
+
+    void AuthSession::Send( Network::ByteBuffer packet )
+    {
+        //! the connection is already gone when this fails, the owner retries
+        if ( !SendBuffer( std::move( packet ) ) )
+            std::cerr << "[ERROR] Could not queue packet for " << m_credentials.m_username << "\n";
     }
 
     void AuthSession::SendLogonChallenge()
     {
         std::cout << "[INFO] SendLogonChallenge\n";
 
-        Network::ByteBuffer packet;
-        packet << Auth::ClientOpcode::LogonChallenge;
-        packet << ( uint8_t )6;
-        packet << ( uint16_t )( m_credentials.m_username.size() + 30 );
-        packet << ( uint32_t )'WoW';
-        packet << CLIENT_VERSION_MAJOR;
-        packet << CLIENT_VERSION_MINOR;
-        packet << CLIENT_VERSION_PATCH;
-        packet << CLIENT_BUILD_NUMBER;
-        packet << ( uint32_t )'68x';
-        packet << ( uint32_t )'niW';
-        packet << ( uint32_t )'SUne';
-        packet << ( uint32_t )0x3c;
-        packet << GetLocalAddress();
-        packet << Network::SizeStringView( m_credentials.m_username );
-
-        SendBuffer( packet );
+        Send( BuildChallenge( Auth::ClientOpcode::LogonChallenge, m_credentials.m_username, GetLocalAddress() ) );
+    }
+
+    void AuthSession::SendReconnectChallenge()
+    {
+        std::cout << "[INFO] SendReconnectChallenge\n";
+
+        Send( BuildChallenge( Auth::ClientOpcode::ReconnectChallenge, m_credentials.m_username, GetLocalAddress() ) );
+    }
+
+    void AuthSession::SendReconnectProof( const FixedArray< 16 > & R1, const Crypto::Sha1::Digest & R2 )
+    {
+        std::cout << "[INFO] SendReconnectProof\n";
+
+        Send( Auth::ClientReconnectProofSchema::Build( { Auth::ClientOpcode::ReconnectProof, R1, R2 } ) );
     }
 
     void AuthSession::SendLogonProof( const Crypto::BigNumber & A, const Crypto::Sha1::Digest & M1 )
     {
         std::cout << "[INFO] SendLogonProof\n";
 
-        Network::ByteBuffer packet;
-        packet << Auth::ClientOpcode::LogonProof;
-        packet << A.GetFixedBytes< 32 >();
-        packet << M1;
-        packet << std::array<std::byte, 20>();
-        packet << ( uint8_t )0;
-        packet << ( uint8_t )0;
+        const auto publicKey = A.GetFixedBytes< 32 >();
+        if ( !publicKey )
+        {
+            std::cerr << "[ERROR] Public key does not fit the logon proof for " << m_credentials.m_username << "\n";
+            return Disconnect();
+        }
 
-        SendBuffer( packet );
+        Send( Auth::ClientLogonProofSchema::Build( { Auth::ClientOpcode::LogonProof, *publicKey, M1 } ) );
     }
 
     void AuthSession::SendRealmListQuery()
     {
         std::cout << "[INFO] SendRealmListQuery\n";
 
-        Network::ByteBuffer packet;
-        packet << Auth::ClientOpcode::RealmList;
-        packet << ( uint8_t )0;
-        packet << ( uint8_t )0;
-        packet << ( uint8_t )0;
-        packet << ( uint8_t )0;
-
-        SendBuffer( packet );
+        Send( Auth::ClientRealmListQuerySchema::Build( { Auth::ClientOpcode::RealmList } ) );
     }
 
     void AuthSession::HandlePacket( const Auth::ServerLogonChallenge & packet )
     {
-        const auto B = Crypto::BigNumber( packet.B );
-        const auto g = Crypto::BigNumber( gsl::span< const std::byte >( ( std::byte * ) & packet.G, 1 ) );
-        const auto N = Crypto::BigNumber( packet.N );
-        const auto Salt = Crypto::BigNumber( packet.S );
-        const auto Unk3 = Crypto::BigNumber( packet.Unk3 );
-
-        //! SRP6 implementation
-        const auto k = Crypto::BigNumber( 3 ); // multiplier
-
-        const auto I = Crypto::Sha1::CalculateHash( m_credentials.m_username, ":", m_credentials.m_password );
-        const auto x = Crypto::BigNumber( Crypto::Sha1::CalculateHash( Salt, I ) ); // private key
-        const auto v = g.ModExp( x, N );                                            // password verifier
-
-        Crypto::BigNumber a;
-        a.Randomize( 19 );
+        //! SRP6 runs on the login pool, the session may be gone by the time the proof is ready
+        auto & loginPool = m_services.m_loginPool;
+        auto lifetime = GetLifetimeToken();
 
-        Crypto::BigNumber A = g.ModExp( a, N );
-
-        auto uHash = Crypto::Sha1::CalculateHash( A, B );
-        const auto u = Crypto::BigNumber( uHash );
-
-        Crypto::BigNumber S = ( B - k * v ).ModExp( ( a + u * x ), N );
-
-        auto t = S.GetBytes( 32 );
-
-        std::array<std::byte, 16> t1{};
-        for ( size_t idx = 0; idx < t1.size(); ++idx )
+        boost::asio::co_spawn( GetExecutor(), [this, &loginPool, lifetime, packet, username = m_credentials.m_username, password = m_credentials.m_password]() -> boost::asio::awaitable< void >
         {
-            t1[ idx ] = t[ idx * 2 ];
-        }
+            auto proof = co_await loginPool.ComputeProofAsync( packet, username, password );
+            if ( lifetime.expired() )
+                co_return;
 
-        std::array<std::byte, 40> vK{};
+            if ( !proof )
+            {
+                std::cerr << "[ERROR] Logon challenge for " << username << " does not fit the protocol fields, dropping the logon connection\n";
+                Disconnect();
+                co_return;
+            }
 
-        auto t1Hash = Crypto::Sha1::CalculateHash( t1 );
-        for ( size_t idx = 0; idx < t1Hash.size(); ++idx )
-        {
-            vK[ idx * 2 ] = t1Hash[ idx ];
-        }
+            m_credentials.M2 = proof->M2;
+            m_credentials.K = std::move( proof->K );
 
-        for ( size_t idx = 0; idx < t1.size(); ++idx )
-        {
-            t1[ idx ] = t[ idx * 2 + 1 ];
-        }
+            SendLogonProof( proof->A, proof->M1 );
+        }, boost::asio::detached );
+    }
 
-        t1Hash = Crypto::Sha1::CalculateHash( t1 );
-        for ( size_t idx = 0; idx < t1Hash.size(); ++idx )
-        {
-            vK[ idx * 2 + 1 ] = t1Hash[ idx ];
-        }
+    void AuthSession::HandlePacket( const Auth::ServerLogonProof & packet )
+    {
+        const bool isProofValid = std::equal( packet.M2.begin(), packet.M2.end(), m_credentials.M2.begin(), m_credentials.M2.end() );
+        if ( !isProofValid )
+            return SendLogonChallenge();
 
-        const auto K = Crypto::BigNumber( vK );
+        m_authenticated = true;
+        SendRealmListQuery();
+    }
 
-        auto nHash = Crypto::Sha1::CalculateHash( N );
-        auto gHash = Crypto::Sha1::CalculateHash( g );
+    void AuthSession::HandlePacket( const Auth::ServerReconnectChallenge & packet )
+    {
+        Crypto::BigNumber random;
+        random.Randomize( 16 );
 
-        for ( size_t idx = 0; idx < gHash.size(); ++idx )
+        const auto R1 = random.GetFixedBytes< 16 >();
+        const auto sessionKey = m_credentials.K.GetFixedBytes< 40 >();
+        if ( !R1 || !sessionKey )
         {
-            nHash[ idx ] ^= gHash[ idx ];
+            std::cerr << "[ERROR] Session key does not fit the reconnect proof for " << m_credentials.m_username << "\n";
+            return Disconnect();
         }
 
-        const auto t3 = Crypto::BigNumber( nHash );
-
-        const auto M = Crypto::Sha1::CalculateHash( m_credentials.m_username );
-        const auto M1 = Crypto::Sha1::CalculateHash( t3, M, Salt, A, B, K );
-
-        m_credentials.K = K;
-        m_credentials.M2 = Crypto::Sha1::CalculateHash( A, M1, K );
+        const auto R2 = Crypto::Sha1::CalculateHash( m_credentials.m_username, *R1, packet.Challenge, *sessionKey );
 
-        SendLogonProof( A, M1 );
+        SendReconnectProof( *R1, R2 );
     }
 
-    void AuthSession::HandlePacket( const Auth::ServerLogonProof & packet )
+    void AuthSession::HandlePacket( const Auth::ServerReconnectProof & /*packet*/ )
     {
-        const bool isProofValid = std::equal( packet.M2.begin(), packet.M2.end(), m_credentials.M2.begin(), m_credentials.M2.end() );
-        if ( !isProofValid )
-            return SendLogonChallenge();
-
+        m_authenticated = true;
         SendRealmListQuery();
     }
 
-    void AuthSession::HandlePacket( const Auth::ServerRealmList & packet )
+    void AuthSession::HandlePacket( AccountRealmList & realmList )
     {
-        if ( packet.empty() )
+        if ( realmList.m_realmList->m_realms.empty() )
             return SendRealmListQuery();
 
-        m_realmList = packet;
+        m_realmList = std::move( realmList.m_realmList );
+        m_charactersCounts = std::move( realmList.m_charactersCounts );
     }
 
     boost::asio::awaitable<bool> AuthSession::ReceiveServerLogonChallengeAsync()
@@ -211,9 +212,10 @@ namespace Wow
 
         auto challenge = co_await ReadAsync< Auth::ServerLogonChallenge >();
 
-        std::lock_guard lock( m_mutex );
-        m_queue.push_back( challenge );
+        while ( !m_queue.TryPush( std::move( challenge ) ) )
+            co_await WaitForConsumerAsync();
 
+        Notify();
         co_return true;
     }
 
@@ -228,65 +230,61 @@ namespace Wow
 
         auto proof = co_await ReadAsync< Auth::ServerLogonProof >();
 
-        std::lock_guard lock( m_mutex );
-        m_queue.push_back( proof );
+        while ( !m_queue.TryPush( std::move( proof ) ) )
+            co_await WaitForConsumerAsync();
 
+        Notify();
         co_return true;
     }
 
-    boost::asio::awaitable<bool> AuthSession::ReceiveServerRealmListAsync()
+    boost::asio::awaitable<bool> AuthSession::ReceiveServerReconnectChallengeAsync()
     {
-        auto packetSize = co_await ReadAsync< uint16_t >();
+        //! the server has no session key for us anymore, the owner falls back to a full logon
+        auto status = co_await ReadAsync< AuthStatus >();
+        if ( status != AuthStatus::Success )
+            co_return false;
 
-        Network::ByteBuffer packet = co_await ReadAsync( packetSize );
+        auto challenge = co_await ReadAsync< Auth::ServerReconnectChallenge >();
 
-        uint32_t unk1 = 0u;
-        unk1 << packet;
+        while ( !m_queue.TryPush( std::move( challenge ) ) )
+            co_await WaitForConsumerAsync();
 
-        uint16_t realmsCount = 0u;
-        realmsCount << packet;
+        Notify();
+        co_return true;
+    }
 
-        Auth::ServerRealmList realmlist;
-        realmlist.reserve( realmsCount );
+    boost::asio::awaitable<bool> AuthSession::ReceiveServerReconnectProofAsync()
+    {
+        auto status = co_await ReadAsync< AuthStatus >();
+        if ( status != AuthStatus::Success )
+            co_return false;
 
-        for ( auto idx = 0u; idx < realmsCount; ++idx )
-        {
-            Auth::ServerRealmInfo & info = realmlist.emplace_back();
-            info.icon << packet;
-            info.lock << packet;
-            info.flags << packet;
-            info.name << packet;
-            info.address << packet;
-            info.populationLevel << packet;
-            info.charactersCount << packet;
-            info.timezone << packet;
-            info.realmId << packet;
-
-            if ( ( int )info.flags & ( int )Auth::RealmFlags::SpecifyBuild )
-            {
-                uint8_t majorVersion = 0u;
-                majorVersion << packet;
+        auto proof = co_await ReadAsync< Auth::ServerReconnectProof >();
 
-                uint8_t minorVersion = 0u;
-                minorVersion << packet;
+        while ( !m_queue.TryPush( std::move( proof ) ) )
+            co_await WaitForConsumerAsync();
 
-                uint8_t patchVersion = 0u;
-                patchVersion << packet;
+        Notify();
+        co_return true;
+    }
 
-                uint16_t buildNumber = 0u;
-                buildNumber << packet;
-            }
-        }
+    boost::asio::awaitable<bool> AuthSession::ReceiveServerRealmListAsync()
+    {
+        auto packetSize = co_await ReadAsync< uint16_t >();
 
-        uint8_t unk2 = 0u;
-        unk2 << packet;
+        Network::PooledBuffer packet = co_await ReadAsync( packetSize );
 
-        uint8_t unk3 = 0u;
-        unk3 << packet;
+        //! bots on the same logon server share one parsed copy of the list
+        auto realmlist = m_services.m_realmLists.Publish( m_logonServer, *packet );
+        packet.Reset();
+
+        if ( !realmlist.m_realmList )
+            co_return false;
 
-        std::lock_guard lock( m_mutex );
-        m_queue.emplace_back( std::move( realmlist ) );
+        while ( !m_queue.TryPush( std::move( realmlist ) ) )
+            co_await WaitForConsumerAsync();
 
+        Notify();
         co_return true;
     }
 }
@@ -2,20 +2,26 @@
 
 #include "crypto/Sha1.hpp"
 #include "client/packets/Packets.hpp"
+#include "client/auth/RealmListRegistry.hpp"
 #include "networking/Socket.hpp"
+#include "networking/SpscQueue.hpp"
 
 #include <string>
 #include <variant>
-#include <deque>
 #include <optional>
+#include <memory>
 
 namespace Wow
 {
+    struct ClientServices;
+
     constexpr uint8_t CLIENT_VERSION_MAJOR = 3;
     constexpr uint8_t CLIENT_VERSION_MINOR = 3;
     constexpr uint8_t CLIENT_VERSION_PATCH = 5;
     constexpr uint16_t CLIENT_BUILD_NUMBER = 12340;
 
+    constexpr uint16_t DEFAULT_LOGON_PORT = 3724;
+
     enum class AuthStatus : uint8_t
     {
         Success = 0x00,
@@ -36,7 +42,7 @@ namespace Wow
         ParrentalControl = 0x0f
     };
 
-    using SessionPacket = std::variant< Auth::ServerLogonChallenge, Auth::ServerLogonProof, Auth::ServerRealmList >;
+    using SessionPacket = std::variant< Auth::ServerLogonChallenge, Auth::ServerLogonProof, Auth::ServerReconnectChallenge, Auth::ServerReconnectProof, AccountRealmList >;
 
     struct Credentials
     {
@@ -50,35 +56,55 @@ namespace Wow
     class AuthSession : public Network::Socket< Auth::ServerOpcode >
     {
     public:
-        AuthSession( boost::asio::io_context & context );
+        AuthSession( boost::asio::io_context & context, ClientServices & services );
+
+        void                            Connect( const std::string & address, std::string_view username, std::string_view password );
 
-        bool                            Connect( Endpoint endpoint, std::string_view username, std::string_view password );
+        //! Re-authenticates with the session key of an earlier logon, costs a single hash instead of the SRP6 handshake
+        void                            Reconnect( const std::string & address, std::string_view username, std::string_view password, Crypto::BigNumber sessionKey );
 
         void                            Update();
 
-        auto                            GetRealmList() const { return m_realmList; }
+        const RealmListSnapshot &       GetRealmList() const { return m_realmList; }
+        const std::vector< uint8_t > &  GetCharactersCounts() const { return m_charactersCounts; }
         const Credentials &             GetCredentials() const { return m_credentials; }
+        bool                            IsAuthenticated() const { return m_authenticated; }
+        size_t                          GetQueueDepth() const { return m_queue.GetSize(); }
 
     private:
+        void                            OnConnected() override;
+
         void                            HandlePacket( const Auth::ServerLogonChallenge & packet );
         void                            HandlePacket( const Auth::ServerLogonProof & packet );
-        void                            HandlePacket( const Auth::ServerRealmList & packet );
+        void                            HandlePacket( const Auth::ServerReconnectChallenge & packet );
+        void                            HandlePacket( const Auth::ServerReconnectProof & packet );
+        void                            HandlePacket( AccountRealmList & realmList );
 
+        void                            Send( Network::ByteBuffer packet );
         void                            SendLogonChallenge();
         void                            SendLogonProof( const Crypto::BigNumber & A, const Crypto::Sha1::Digest & M1 );
+        void                            SendReconnectChallenge();
+        void                            SendReconnectProof( const FixedArray< 16 > & R1, const Crypto::Sha1::Digest & R2 );
         void                            SendRealmListQuery();
 
         boost::asio::awaitable<bool>    ReceivePacketAsync( Auth::ServerOpcode opcode ) override;
 
         boost::asio::awaitable<bool>    ReceiveServerLogonChallengeAsync();
         boost::asio::awaitable<bool>    ReceiveServerLogonProofAsync();
+        boost::asio::awaitable<bool>    ReceiveServerReconnectChallengeAsync();
+        boost::asio::awaitable<bool>    ReceiveServerReconnectProofAsync();
         boost::asio::awaitable<bool>    ReceiveServerRealmListAsync();
 
-        std::optional< std::vector< Auth::ServerRealmInfo > > m_realmList;
+        RealmListSnapshot               m_realmList;
+        std::vector< uint8_t >          m_charactersCounts;     // in realm order, the snapshot only holds what every account shares
+
+        Network::SpscQueue< SessionPacket, 16 > m_queue;
 
-        std::mutex                      m_mutex;
-        std::deque<SessionPacket>       m_queue;
+        ClientServices &                m_services;
+        std::string                     m_logonServer;
+        bool                            m_isReconnect;
 
         Credentials                     m_credentials;
+        bool                            m_authenticated;
     };
 }
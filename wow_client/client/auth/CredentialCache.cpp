@@ -0,0 +1,202 @@
+#include "client/auth/CredentialCache.hpp"
+#include "client/PrivateFile.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace Wow
+{
+    namespace
+    {
+        template< typename T >
+        void ReadField( std::istream & file, T & field )
+        {
+            file.read( ( char* )&field, sizeof( field ) );
+        }
+
+        template< typename T >
+        void WriteField( std::ostream & file, const T & field )
+        {
+            file.write( ( const char* )&field, sizeof( field ) );
+        }
+    }
+
+    bool CredentialCache::Find( std::string_view username, const Auth::ServerLogonChallenge & challenge, const Crypto::Sha1::Digest & privateKey, FixedArray< 32 > & verifier ) const
+    {
+        const auto privateKeyHash = Crypto::Sha1::CalculateHash( privateKey );
+
+        std::shared_lock lock( m_mutex );
+
+        auto itr = m_entries.find( username );
+        if ( itr == m_entries.end() )
+            return false;
+
+        const auto & entry = itr->second;
+        if ( entry.m_salt != challenge.S || entry.m_modulus != challenge.N || entry.m_generator != challenge.G || entry.m_privateKeyHash != privateKeyHash )
+            return false;
+
+        verifier = entry.m_verifier;
+        return true;
+    }
+
+    void CredentialCache::Store( std::string_view username, const Auth::ServerLogonChallenge & challenge, const Crypto::Sha1::Digest & privateKey, const FixedArray< 32 > & verifier )
+    {
+        const CachedCredentials credentials{ challenge.S, challenge.N, challenge.G, Crypto::Sha1::CalculateHash( privateKey ), verifier };
+
+        std::unique_lock lock( m_mutex );
+        m_entries.insert_or_assign( std::string( username ), credentials );
+    }
+
+    size_t CredentialCache::GetSize() const
+    {
+        std::shared_lock lock( m_mutex );
+        return m_entries.size();
+    }
+
+    void CredentialCache::PrecomputeIdentities( gsl::span< const std::pair< std::string_view, std::string_view > > accounts )
+    {
+        std::vector< std::string > messages;
+        messages.reserve( accounts.size() );
+
+        for ( const auto & [ username, password ] : accounts )
+        {
+            auto & message = messages.emplace_back( username );
+            message.append( ":" ).append( password );
+        }
+
+        std::vector< gsl::span< const std::byte > > spans;
+        spans.reserve( messages.size() );
+
+        for ( const auto & message : messages )
+            spans.emplace_back( reinterpret_cast< const std::byte * >( message.data() ), message.size() );
+
+        std::vector< Crypto::Sha1::Digest > identities( accounts.size() );
+        Crypto::Sha1::CalculateHashBatch( spans, identities );
+
+        std::unique_lock lock( m_mutex );
+        for ( size_t idx = 0u; idx < accounts.size(); ++idx )
+            m_identities.insert_or_assign( std::string( accounts[ idx ].first ), Identity{ std::string( accounts[ idx ].second ), identities[ idx ] } );
+    }
+
+    bool CredentialCache::FindIdentity( std::string_view username, std::string_view password, Crypto::Sha1::Digest & identity ) const
+    {
+        std::shared_lock lock( m_mutex );
+
+        auto itr = m_identities.find( username );
+        if ( itr == m_identities.end() || itr->second.m_password != password )
+            return false;
+
+        identity = itr->second.m_identity;
+        return true;
+    }
+
+    bool CredentialCache::Load( const std::string & path )
+    {
+        std::ifstream file( path, std::ios::binary );
+        if ( !file )
+            return false;
+
+        uint32_t magic = 0u;
+        uint32_t count = 0u;
+        ReadField( file, magic );
+        ReadField( file, count );
+
+        if ( !file || magic != FILE_MAGIC )
+        {
+            std::cerr << "[ERROR] Invalid credential cache: " << path << "\n";
+            return false;
+        }
+
+        //! the count is not trusted for a reserve, a damaged file fails on the reads below instead
+        UsernameMap< CachedCredentials > entries;
+
+        for ( uint32_t idx = 0u; idx < count; ++idx )
+        {
+            uint8_t length = 0u;
+            ReadField( file, length );
+
+            std::string username( length, '\0' );
+            file.read( username.data(), length );
+
+            CachedCredentials credentials;
+            ReadField( file, credentials.m_salt );
+            ReadField( file, credentials.m_modulus );
+            ReadField( file, credentials.m_generator );
+            ReadField( file, credentials.m_privateKeyHash );
+            ReadField( file, credentials.m_verifier );
+
+            if ( !file || length == 0u || credentials.m_generator == 0u )
+            {
+                std::cerr << "[ERROR] Damaged credential cache: " << path << "\n";
+                return false;
+            }
+
+            entries.insert_or_assign( std::move( username ), credentials );
+        }
+
+        if ( file.peek() != std::ifstream::traits_type::eof() )
+        {
+            std::cerr << "[ERROR] Damaged credential cache: " << path << "\n";
+            return false;
+        }
+
+        std::unique_lock lock( m_mutex );
+        m_entries.merge( entries );
+
+        return true;
+    }
+
+    bool CredentialCache::Save( const std::string & path ) const
+    {
+        //! written next to the old file and renamed over it, a crash mid write keeps the previous cache
+        const std::string temporaryPath = path + ".tmp";
+        {
+            //! the verifiers allow offline password guessing, nobody but the user gets to read them
+            std::ofstream file;
+            if ( CreatePrivateFile( temporaryPath ) )
+                file.open( temporaryPath, std::ios::binary | std::ios::trunc );
+
+            if ( !file.is_open() )
+            {
+                std::cerr << "[ERROR] Could not write credential cache: " << temporaryPath << "\n";
+                return false;
+            }
+
+            std::shared_lock lock( m_mutex );
+
+            uint32_t count = 0u;
+            for ( const auto & [ username, credentials ] : m_entries )
+                count += username.size() <= UINT8_MAX;
+
+            WriteField( file, FILE_MAGIC );
+            WriteField( file, count );
+
+            for ( const auto & [ username, credentials ] : m_entries )
+            {
+                if ( username.size() > UINT8_MAX )
+                    continue;
+
+                const uint8_t length = ( uint8_t )username.size();
+                WriteField( file, length );
+                file.write( username.data(), length );
+
+                WriteField( file, credentials.m_salt );
+                WriteField( file, credentials.m_modulus );
+                WriteField( file, credentials.m_generator );
+                WriteField( file, credentials.m_privateKeyHash );
+                WriteField( file, credentials.m_verifier );
+            }
+
+            if ( !file )
+                return false;
+        }
+
+        std::error_code error;
+        std::filesystem::rename( temporaryPath, path, error );
+
+        return !error;
+    }
+}
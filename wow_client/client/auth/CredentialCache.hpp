@@ -0,0 +1,77 @@
+#pragma once
+
+#include "crypto/Sha1.hpp"
+#include "client/packets/Packets.hpp"
+
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace Wow
+{
+    //! SRP6 values that only depend on the account and the salt, the salt of an account never changes
+    //! so re-logins skip the verifier modexp. I and x are enough to log in and are never kept, the verifier
+    //! and the hash of x only allow the same offline guessing as the server's own account database.
+    struct CachedCredentials
+    {
+        FixedArray< 32 >        m_salt;
+        FixedArray< 32 >        m_modulus;
+        uint8_t                 m_generator;
+        Crypto::Sha1::Digest    m_privateKeyHash;   // H( x ), tells whether the password still matches
+        FixedArray< 32 >        m_verifier;         // v = g^x mod N
+    };
+
+    //! Shared by all login workers, lookups take a shared lock so they never serialize each other.
+    //! Entries are stored per username and only used when the salt, the group and the password still match.
+    class CredentialCache
+    {
+    public:
+        static constexpr uint32_t FILE_MAGIC = 'WCC2';
+
+        //! `privateKey` is x = H( salt, I ) of the current password
+        bool                    Find( std::string_view username, const Auth::ServerLogonChallenge & challenge, const Crypto::Sha1::Digest & privateKey, FixedArray< 32 > & verifier ) const;
+        void                    Store( std::string_view username, const Auth::ServerLogonChallenge & challenge, const Crypto::Sha1::Digest & privateKey, const FixedArray< 32 > & verifier );
+
+        size_t                  GetSize() const;
+
+        //! I = H( username : password ) does not depend on the server, so the identities of a whole fleet are
+        //! hashed up front in one batch and the logins only look them up
+        void                    PrecomputeIdentities( gsl::span< const std::pair< std::string_view, std::string_view > > accounts );
+        bool                    FindIdentity( std::string_view username, std::string_view password, Crypto::Sha1::Digest & identity ) const;
+
+        //! Binary file: magic, entries count, then per entry the username length, the username and the credentials fields.
+        //! Saved readable by the current user only.
+        bool                    Load( const std::string & path );
+        bool                    Save( const std::string & path ) const;
+
+    private:
+        struct Identity
+        {
+            std::string             m_password;
+            Crypto::Sha1::Digest    m_identity;
+        };
+
+        //! lets the string_view usernames of the logins look entries up without building a std::string
+        struct UsernameHash
+        {
+            using is_transparent = void;
+
+            size_t operator()( std::string_view username ) const
+            {
+                return std::hash< std::string_view >{}( username );
+            }
+        };
+
+        template< typename T >
+        using UsernameMap = std::unordered_map< std::string, T, UsernameHash, std::equal_to<> >;
+
+        mutable std::shared_mutex               m_mutex;
+        UsernameMap< CachedCredentials >        m_entries;
+
+        //! not persisted, it is rebuilt from the accounts on every run
+        UsernameMap< Identity >                 m_identities;
+    };
+}
@@ -0,0 +1,149 @@
+#include "client/auth/LoginWorkerPool.hpp"
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+namespace Wow
+{
+    LoginWorkerPool::LoginWorkerPool( size_t threadsCount )
+        : m_pool( std::max< size_t >( threadsCount, 1u ) )
+        , m_completed( 0u )
+        , m_lastSampleCount( 0u )
+        , m_lastSampleTime( std::chrono::steady_clock::now() )
+    {
+    }
+
+    LoginWorkerPool::~LoginWorkerPool()
+    {
+        Shutdown();
+    }
+
+    void LoginWorkerPool::Shutdown()
+    {
+        //! no stop(), a proof dropped from the queue would be destroyed with the pool while holding a shard's work guard and caller frame
+        m_pool.join();
+    }
+
+    boost::asio::awaitable< std::optional< LogonProof > > LoginWorkerPool::ComputeProofAsync( Auth::ServerLogonChallenge challenge, std::string username, std::string password )
+    {
+        //! the inputs move into the worker's own frame, it never reaches back into the awaiting one
+        co_return co_await boost::asio::co_spawn( m_pool, ComputeProofOnPoolAsync( std::move( challenge ), std::move( username ), std::move( password ) ), boost::asio::use_awaitable );
+    }
+
+    boost::asio::awaitable< std::optional< LogonProof > > LoginWorkerPool::ComputeProofOnPoolAsync( Auth::ServerLogonChallenge challenge, std::string username, std::string password )
+    {
+        auto proof = ComputeProof( challenge, username, password );
+        ++m_completed;
+
+        co_return proof;
+    }
+
+    double LoginWorkerPool::SampleLoginsPerSecond()
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const uint64_t completed = m_completed;
+
+        const std::chrono::duration< double > elapsed = now - m_lastSampleTime;
+        const double rate = elapsed.count() > 0.0 ? ( completed - m_lastSampleCount ) / elapsed.count() : 0.0;
+
+        m_lastSampleCount = completed;
+        m_lastSampleTime = now;
+
+        return rate;
+    }
+
+    std::optional< LogonProof > LoginWorkerPool::ComputeProof( const Auth::ServerLogonChallenge & challenge, std::string_view username, std::string_view password )
+    {
+        const auto B = Crypto::BigNumber( challenge.B );
+        const auto g = Crypto::BigNumber( gsl::span< const std::byte >( ( std::byte * ) & challenge.G, 1 ) );
+        const auto N = Crypto::BigNumber( challenge.N );
+        const auto Salt = Crypto::BigNumber( challenge.S );
+
+        //! SRP6 implementation
+        const auto k = Crypto::BigNumber( 3 ); // multiplier
+
+        Crypto::Sha1::Digest I;
+        if ( !m_credentialCache.FindIdentity( username, password, I ) )
+            I = Crypto::Sha1::CalculateHash( username, ":", password );
+
+        const auto privateKey = Crypto::Sha1::CalculateHash( Salt, I );
+        const auto x = Crypto::BigNumber( privateKey ); // private key
+
+        Crypto::BigNumber v; // password verifier
+
+        FixedArray< 32 > verifier;
+        if ( m_credentialCache.Find( username, challenge, privateKey, verifier ) )
+        {
+            v = Crypto::BigNumber( verifier );
+        }
+        else
+        {
+            v = g.ModExp( x, N );
+
+            const auto verifierBytes = v.GetFixedBytes< 32 >();
+            if ( !verifierBytes )
+                return std::nullopt;
+
+            m_credentialCache.Store( username, challenge, privateKey, *verifierBytes );
+        }
+
+        Crypto::BigNumber a;
+        a.Randomize( 19 );
+
+        Crypto::BigNumber A = g.ModExp( a, N );
+
+        auto uHash = Crypto::Sha1::CalculateHash( A, B );
+        const auto u = Crypto::BigNumber( uHash );
+
+        Crypto::BigNumber S = ( B - k * v ).ModExp( u * x + a, N );
+
+        const auto sessionSecret = S.GetFixedBytes< 32 >();
+        if ( !sessionSecret )
+            return std::nullopt;
+
+        const auto & t = *sessionSecret;
+
+        std::array<std::byte, 16> t1{};
+        for ( size_t idx = 0; idx < t1.size(); ++idx )
+        {
+            t1[ idx ] = t[ idx * 2 ];
+        }
+
+        std::array<std::byte, 40> vK{};
+
+        auto t1Hash = Crypto::Sha1::CalculateHash( t1 );
+        for ( size_t idx = 0; idx < t1Hash.size(); ++idx )
+        {
+            vK[ idx * 2 ] = t1Hash[ idx ];
+        }
+
+        for ( size_t idx = 0; idx < t1.size(); ++idx )
+        {
+            t1[ idx ] = t[ idx * 2 + 1 ];
+        }
+
+        t1Hash = Crypto::Sha1::CalculateHash( t1 );
+        for ( size_t idx = 0; idx < t1Hash.size(); ++idx )
+        {
+            vK[ idx * 2 + 1 ] = t1Hash[ idx ];
+        }
+
+        auto K = Crypto::BigNumber( vK );
+
+        auto nHash = Crypto::Sha1::CalculateHash( N );
+        auto gHash = Crypto::Sha1::CalculateHash( g );
+
+        for ( size_t idx = 0; idx < gHash.size(); ++idx )
+        {
+            nHash[ idx ] ^= gHash[ idx ];
+        }
+
+        const auto t3 = Crypto::BigNumber( nHash );
+
+        const auto M = Crypto::Sha1::CalculateHash( username );
+        const auto M1 = Crypto::Sha1::CalculateHash( t3, M, Salt, A, B, K );
+        const auto M2 = Crypto::Sha1::CalculateHash( A, M1, K );
+
+        return LogonProof{ std::move( A ), M1, std::move( K ), M2 };
+    }
+}
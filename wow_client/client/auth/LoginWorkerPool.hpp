@@ -0,0 +1,60 @@
+#pragma once
+
+#include "client/auth/CredentialCache.hpp"
+#include "crypto/BigNumber.hpp"
+#include "crypto/Sha1.hpp"
+#include "client/packets/Packets.hpp"
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace Wow
+{
+    struct LogonProof
+    {
+        Crypto::BigNumber       A;
+        Crypto::Sha1::Digest    M1;
+        Crypto::BigNumber       K;
+        Crypto::Sha1::Digest    M2;
+    };
+
+    //! Runs the SRP6 client computations on dedicated threads, so a burst of logon challenges
+    //! is spread over all cores instead of stalling the io shards
+    class LoginWorkerPool
+    {
+    public:
+        LoginWorkerPool( size_t threadsCount );
+        ~LoginWorkerPool();
+
+        //! Runs every queued proof to completion and joins the workers, must run before the executors awaiting them go away
+        void                                    Shutdown();
+
+        //! Computes the proof on the pool, the awaiting coroutine resumes on its own executor
+        boost::asio::awaitable< std::optional< LogonProof > >   ComputeProofAsync( Auth::ServerLogonChallenge challenge, std::string username, std::string password );
+
+        //! Empty when the challenge values don't fit the 32 byte protocol fields
+        std::optional< LogonProof >                             ComputeProof( const Auth::ServerLogonChallenge & challenge, std::string_view username, std::string_view password );
+
+        CredentialCache &                       GetCredentialCache() { return m_credentialCache; }
+
+        uint64_t                                GetCompletedCount() const { return m_completed; }
+
+        //! Logins per second since the previous call, meant to be sampled from a single monitoring thread
+        double                                  SampleLoginsPerSecond();
+
+    private:
+        boost::asio::awaitable< std::optional< LogonProof > >   ComputeProofOnPoolAsync( Auth::ServerLogonChallenge challenge, std::string username, std::string password );
+
+        boost::asio::thread_pool                m_pool;
+        std::atomic< uint64_t >                 m_completed;
+        CredentialCache                         m_credentialCache;
+
+        uint64_t                                m_lastSampleCount;
+        std::chrono::steady_clock::time_point   m_lastSampleTime;
+    };
+}
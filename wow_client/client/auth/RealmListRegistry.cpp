@@ -0,0 +1,119 @@
+#include "client/auth/RealmListRegistry.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+
+namespace Wow
+{
+    static bool IsSameKey( const RealmListSnapshot & snapshot, const std::string & key )
+    {
+        return snapshot && snapshot->m_key == key;
+    }
+
+    AccountRealmList RealmListRegistry::Publish( const std::string & logonServer, Network::ByteBuffer & packet )
+    {
+        AccountRealmList result;
+
+        //! strings borrow from the packet, nothing is copied unless the list turns out to be new
+        Auth::ServerRealmList realms;
+        if ( auto parsed = Parse( packet.m_data, realms ); !parsed )
+        {
+            std::cerr << "[ERROR] Malformed realmlist from " << logonServer << ": " << Network::ToString( parsed.error() ) << "\n";
+            return result;
+        }
+
+        result.m_charactersCounts.reserve( realms.size() );
+        for ( auto & realm : realms )
+            result.m_charactersCounts.push_back( realm.charactersCount );
+
+        const std::string key = BuildKey( realms );
+        {
+            std::shared_lock lock( m_mutex );
+
+            auto itr = m_lists.find( logonServer );
+            if ( itr != m_lists.end() && IsSameKey( itr->second, key ) )
+            {
+                result.m_realmList = itr->second;
+                return result;
+            }
+        }
+
+        std::unique_lock lock( m_mutex );
+
+        //! another bot may have published the same list while the lock was released
+        auto & snapshot = m_lists[ logonServer ];
+        if ( IsSameKey( snapshot, key ) )
+        {
+            result.m_realmList = snapshot;
+            return result;
+        }
+
+        auto realmList = std::make_shared< RealmList >();
+        realmList->m_key = key;
+        realmList->m_payload.assign( packet.m_data.begin(), packet.m_data.end() );
+
+        //! same bytes that were just parsed, it can't fail
+        Parse( realmList->m_payload, realmList->m_realms );
+        for ( auto & realm : realmList->m_realms )
+            realm.charactersCount = 0u;
+
+        realmList->m_version = ++m_version;
+
+        std::cout << "[INFO] Realmlist of " << logonServer << " ( version " << realmList->m_version << " ):\n";
+        for ( auto & info : realmList->m_realms )
+            std::cout << " - " << info.name << " (" << info.address << ")\n";
+
+        snapshot = std::move( realmList );
+
+        result.m_realmList = snapshot;
+        return result;
+    }
+
+    RealmListSnapshot RealmListRegistry::Find( const std::string & logonServer ) const
+    {
+        std::shared_lock lock( m_mutex );
+
+        auto itr = m_lists.find( logonServer );
+        return itr != m_lists.end() ? itr->second : nullptr;
+    }
+
+    Network::ReadResult< void > RealmListRegistry::Parse( gsl::span< const std::byte > payload, Auth::ServerRealmList & realms )
+    {
+        Network::ByteBufferView reader( payload );
+
+        Auth::ServerRealmListPayload realmList;
+        if ( auto result = Auth::ServerRealmListSchema::Read( reader, realmList ); !result )
+            return result;
+
+        realms = std::move( realmList.realms );
+        return {};
+    }
+
+    std::string RealmListRegistry::BuildKey( const Auth::ServerRealmList & realms )
+    {
+        //! the characters count and lock differ per account, everything else is the same for the whole fleet
+        std::string key;
+        for ( auto & realm : realms )
+        {
+            key.append( realm.name ).push_back( '\0' );
+            key.append( realm.address ).push_back( '\0' );
+
+            key.push_back( static_cast< char >( realm.flags ) );
+            key.push_back( static_cast< char >( realm.icon ) );
+            key.append( reinterpret_cast< const char * >( &realm.populationLevel ), sizeof( realm.populationLevel ) );
+            key.push_back( static_cast< char >( realm.timezone ) );
+            key.push_back( static_cast< char >( realm.realmId ) );
+
+            if ( ( uint8_t )realm.flags & ( uint8_t )Auth::RealmFlags::SpecifyBuild )
+            {
+                key.push_back( static_cast< char >( realm.majorVersion ) );
+                key.push_back( static_cast< char >( realm.minorVersion ) );
+                key.push_back( static_cast< char >( realm.patchVersion ) );
+                key.append( reinterpret_cast< const char * >( &realm.buildNumber ), sizeof( realm.buildNumber ) );
+            }
+        }
+
+        return key;
+    }
+}
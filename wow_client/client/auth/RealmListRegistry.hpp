@@ -0,0 +1,58 @@
+#pragma once
+
+#include "client/packets/Packets.hpp"
+#include "networking/ByteBuffer.hpp"
+#include "networking/ByteBufferView.hpp"
+
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <gsl/span>
+
+namespace Wow
+{
+    //! Immutable once published, bots only ever hold it through a shared pointer.
+    //! Only the part of the list every account receives alike is shared, the characters counts are zeroed.
+    struct RealmList
+    {
+        uint64_t                    m_version;
+
+        //! name, address, flags, icon, population, timezone, id and build of every realm in order,
+        //! incoming lists are compared against it and a changed population publishes a new version
+        std::string                 m_key;
+        Auth::ServerRealmList       m_realms;
+
+        //! raw payload of the first list with this key, the realms are parsed from it and their strings point into it
+        std::vector< std::byte >    m_payload;
+    };
+
+    using RealmListSnapshot = std::shared_ptr< const RealmList >;
+
+    //! The list as one account received it, the shared snapshot and the per account counts in realm order
+    struct AccountRealmList
+    {
+        RealmListSnapshot           m_realmList;
+        std::vector< uint8_t >      m_charactersCounts;
+    };
+
+    //! Latest realm list of every logon server, shared by the whole fleet.
+    //! Bots receiving an unchanged list get the existing snapshot back, so no matter how many bots
+    //! there are a list is stored once, and a new version is only made when its content changes.
+    class RealmListRegistry
+    {
+    public:
+        //! The snapshot is null when the list is malformed
+        AccountRealmList            Publish( const std::string & logonServer, Network::ByteBuffer & packet );
+        RealmListSnapshot           Find( const std::string & logonServer ) const;
+
+    private:
+        static Network::ReadResult< void > Parse( gsl::span< const std::byte > payload, Auth::ServerRealmList & realms );
+        static std::string                 BuildKey( const Auth::ServerRealmList & realms );
+
+        mutable std::shared_mutex                               m_mutex;
+        std::unordered_map< std::string, RealmListSnapshot >    m_lists;
+        uint64_t                                                m_version = 0u;
+    };
+}
@@ -2,32 +2,33 @@
 #include "crypto/HmacHash.hpp"
 #include "networking/ByteBuffer.hpp"
 
+#include <cstring>
 #include <iostream>
 #include <ios>
 
 namespace Wow
 {
-    static Crypto::HmacHash::Digest GetDigest( gsl::span< const uint8_t > key, const Crypto::BigNumber & seed )
+    bool PacketCrypto::Initialize( const Crypto::BigNumber & seed )
     {
-        Crypto::HmacHash hmac( { ( const std::byte * ) key.data(), key.size() } );
+        //! both keys are constant, their HMAC states are set up once and shared by every session
+        static const Crypto::HmacHash decryptHmac( { ( const std::byte * ) DECRYPTION_KEY.data(), DECRYPTION_KEY.size() } );
+        static const Crypto::HmacHash encryptHmac( { ( const std::byte * ) ENCRYPTION_KEY.data(), ENCRYPTION_KEY.size() } );
 
-        auto seedBytes = seed.GetBytes();
-        return hmac.ComputeHash( seedBytes );
-    }
+        const auto seedBytes = seed.GetFixedBytes< SESSION_KEY_LENGTH >();
+        if ( !seedBytes )
+            return false;
 
-    void PacketCrypto::Initialize( const Crypto::BigNumber & seed )
-    {
-        auto digest = GetDigest( DECRYPTION_KEY, seed );
+        auto digest = decryptHmac.ComputeHash( *seedBytes );
         m_decrypt.emplace( digest );
 
-        digest = GetDigest( DECRYPTION_KEY, seed );
+        digest = encryptHmac.ComputeHash( *seedBytes );
         m_encrypt.emplace( digest );
 
         //! Drop first 1024 bytes
-        std::array< std::byte, 1024 > dummy = {};
+        m_decrypt->Drop( 1024 );
+        m_encrypt->Drop( 1024 );
 
-        m_decrypt->Process( dummy );
-        m_encrypt->Process( dummy );
+        return true;
     }
 
     void PacketCrypto::Decrypt( gsl::span< std::byte > buffer )
@@ -44,87 +45,129 @@ namespace Wow
 
     GameSession::GameSession( boost::asio::io_context & context, const Crypto::BigNumber & key )
         : Socket( context )
+        , m_droppedPackets( 0u )
+        , m_authenticated( false )
         , m_cryptoKey( key )
     {
+        //! the header keystream advances for every packet, a skipped one can't be resumed
+        SetHighWaterPolicy( Network::HighWaterPolicy::Disconnect );
     }
 
-    bool GameSession::Connect( Endpoint endpoint )
+    void GameSession::Connect( Network::EndpointResolver & resolver, const std::string & address )
+    {
+        ConnectAsync( resolver, address, DEFAULT_WORLD_PORT );
+    }
+
+    void GameSession::Update()
     {
-        const auto error = Socket::Connect( endpoint );
-        if ( error )
+        m_queue.Drain( [this]( QueuedPacket & queued )
         {
-            std::cerr << "[ERROR] " << error << "\n";
-            return false;
-        }
+            auto & [opcode, packet] = queued;
+            HandlePacket( OpcodeTable::Instance()[ opcode ], *packet );
 
-        return true;
+            //! the slot keeps its value until it is reused, the storage goes back to the pool right away
+            packet.Reset();
+        } );
     }
 
-    void GameSession::Update()
+    void GameSession::HandlePacket( const OpcodeHandler & handler, Network::ByteBuffer & packet )
     {
-        std::lock_guard lock( m_mutex );
-        while( !m_queue.empty() )
+        if ( !handler.m_handler( *this, packet ) )
         {
-            auto [opcode, packet] = std::move( m_queue.front() );
-            m_queue.pop_front();
-
-            switch ( opcode )
-            {
-                case Game::ServerOpcode::AuthChallenge: HandleAuthChallenge( std::move( packet ) ); break;
-                default:
-                {
-                    std::cerr << "ERROR: unhandled opcode: " << std::hex << ( uint32_t )opcode << "\n";
-                    std::terminate();
-                }
-            }
+            std::cerr << "[ERROR] malformed packet: " << handler.m_name << "\n";
+            ++m_droppedPackets;
         }
     }
 
-    void GameSession::HandleAuthChallenge( Network::ByteBuffer packet )
+    void GameSession::HandleAuthChallenge( const Game::ServerAuthChallenge & /*challenge*/ )
     {
-        Game::ServerAuthChallenge challenge;
-        challenge << packet;
+        std::cout << "[INFO] HandleAuthChallenge\n";
 
+        SendPacket< Game::ClientAuthSessionSchema >( Game::ClientOpcode::AuthSession, {} );
 
-        std::cout << "[INFO] HandleAuthChallenge\n";
+        //! everything after CMSG_AUTH_SESSION has its header encrypted
+        m_crypto.emplace();
+        if ( !m_crypto->Initialize( m_cryptoKey ) )
+        {
+            std::cerr << "[ERROR] Session key does not fit the packet crypto, dropping the connection\n";
+            Disconnect();
+        }
+    }
+
+    void GameSession::WriteHeader( Network::ByteBuffer & packet, Game::ClientOpcode opcode )
+    {
+        const size_t size = packet.m_data.size() - Game::CLIENT_HEADER_SIZE + sizeof( opcode );
+
+        auto header = gsl::span< std::byte >( packet.m_data ).first( Game::CLIENT_HEADER_SIZE );
+        header[ 0 ] = std::byte( size >> 8 );
+        header[ 1 ] = std::byte( size );
+        std::memcpy( &header[ 2 ], &opcode, sizeof( opcode ) );
 
-        Network::ByteBuffer response_packet;
-        response_packet << Game::ClientOpcode::AuthSession;
-        response_packet << ( uint8_t )0;
-        response_packet << ( uint8_t )0;
-        response_packet << ( uint8_t )0;
-        response_packet << ( uint8_t )0;
+        if ( m_crypto )
+            m_crypto->Encrypt( header );
+    }
 
-        SendBuffer( packet );
+    void GameSession::HandleAuthResponse( const Game::ServerAuthResponse & response )
+    {
+        m_authenticated = response.Result == Game::ResponseCode::AuthOk;
 
+        if ( !m_authenticated )
+            std::cerr << "[ERROR] HandleAuthResponse: " << ( int )response.Result << "\n";
     }
 
     boost::asio::awaitable<bool> GameSession::ReceivePacketAsync( std::byte header )
     {
-        std::byte temp = header;
-        m_crypto->Decrypt( { &temp, 1 } );
+        //! server header: size ( 2 bytes big endian, 3 bytes when the top bit is set ) followed by opcode ( 2 bytes little endian )
+        std::array< std::byte, 5 > headerBytes = { header };
 
-        const bool isLargePacket = ( ( uint8_t )header & 0x80 ) != 0;
+        if ( m_crypto )
+            m_crypto->Decrypt( { headerBytes.data(), 1 } );
 
-        auto buffer = co_await ReadAsync( isLargePacket ? 4 : 3 );
-        m_crypto->Decrypt( buffer.m_data );
+        const bool isLargePacket = ( ( uint8_t )headerBytes[ 0 ] & 0x80 ) != 0;
+        const size_t headerSize = isLargePacket ? 5 : 4;
 
-        if ( !isLargePacket )
-        {
-            buffer.m_data.insert( buffer.m_data.begin(), header );
-        }
+        //! in steady state everything is buffered and the rest of the packet is read without further coroutine frames
+        const auto remainingHeader = gsl::span< std::byte >( headerBytes ).subspan( 1, headerSize - 1 );
+        if ( !TryRead( remainingHeader ) )
+            co_await ReadAsync( remainingHeader );
 
-        Game::ServerOpcode opcode = ( Game::ServerOpcode )( ( uint8_t )buffer.m_data[ 2 ] << 8 | ( uint8_t )buffer.m_data[ 3 ] );
+        if ( m_crypto )
+            m_crypto->Decrypt( remainingHeader );
 
-        size_t packetSize = ( isLargePacket ? ( uint8_t )header & 0x7F << 16 : 0 ) | ( uint8_t )buffer.m_data[ 0 ] << 8 | ( uint8_t )buffer.m_data[ 1 ];
+        const auto * bytes = reinterpret_cast< const uint8_t * >( headerBytes.data() );
 
-        auto packet = co_await ReadAsync( packetSize );
+        const size_t packetSize = isLargePacket
+            ? ( bytes[ 0 ] & 0x7F ) << 16 | bytes[ 1 ] << 8 | bytes[ 2 ]
+            : bytes[ 0 ] << 8 | bytes[ 1 ];
 
+        const auto opcode = ( Game::ServerOpcode )( bytes[ headerSize - 2 ] | bytes[ headerSize - 1 ] << 8 );
+
+        //! size includes the opcode
+        if ( packetSize < 2 )
+            co_return false;
+
+        Network::PooledBuffer packet( Network::BufferPool::GetThreadPool().Acquire( packetSize - 2 ) );
+        if ( !TryRead( packet->m_data ) )
+            co_await ReadAsync( gsl::span< std::byte >( packet->m_data ) );
+
+        const auto & handler = OpcodeTable::Instance()[ opcode ];
+        if ( !handler.m_handler )
         {
-            std::lock_guard lock( m_mutex );
-            m_queue.emplace_back( opcode, std::move( packet ) );
+            ++m_droppedPackets;
+            co_return true;
         }
 
+        if ( handler.m_processing == PacketProcessing::Inline )
+        {
+            HandlePacket( handler, *packet );
+            co_return true;
+        }
+
+        QueuedPacket queued{ opcode, std::move( packet ) };
+        while ( !m_queue.TryPush( std::move( queued ) ) )
+            co_await WaitForConsumerAsync();
+
+        Notify();
         co_return true;
     }
 }
@@ -1,24 +1,30 @@
 #pragma once
 
 #include "networking/Socket.hpp"
+#include "networking/SpscQueue.hpp"
 #include "client/packets/Packets.hpp"
+#include "client/game/OpcodeTable.hpp"
 #include "crypto/Arc4.hpp"
 
-#include <deque>
+#include <atomic>
 #include <gsl/span>
 #include <optional>
 
 namespace Wow
 {
+    constexpr uint16_t DEFAULT_WORLD_PORT = 8085;
+
     struct PacketCrypto
     {
-        const std::array<std::uint8_t, 16> ENCRYPTION_KEY =
+        static constexpr size_t SESSION_KEY_LENGTH = 40;
+
+        static constexpr std::array<std::uint8_t, 16> ENCRYPTION_KEY =
         {
             0xC2, 0xB3, 0x72, 0x3C, 0xC6, 0xAE, 0xD9, 0xB5,
             0x34, 0x3C, 0x53, 0xEE, 0x2F, 0x43, 0x67, 0xCE
         };
 
-        const std::array<std::uint8_t, 16> DECRYPTION_KEY =
+        static constexpr std::array<std::uint8_t, 16> DECRYPTION_KEY =
         {
             0xCC, 0x98, 0xAE, 0x04, 0xE8, 0x97, 0xEA, 0xCA,
             0x12, 0xDD, 0xC0, 0x93, 0x42, 0x91, 0x53, 0x57
@@ -26,7 +32,8 @@ namespace Wow
 
         PacketCrypto() = default;
 
-        void                            Initialize( const Crypto::BigNumber & seed );
+        //! Fails when the seed is not a session key
+        bool                            Initialize( const Crypto::BigNumber & seed );
 
         void                            Decrypt( gsl::span< std::byte > buffer );
         void                            Encrypt( gsl::span< std::byte > buffer );
@@ -40,18 +47,44 @@ namespace Wow
     public:
         GameSession( boost::asio::io_context & context, const Crypto::BigNumber & key );
 
-        bool    Connect( Endpoint endpoint );
+        void    Connect( Network::EndpointResolver & resolver, const std::string & address );
         void    Update();
 
+        size_t  GetQueueDepth() const { return m_queue.GetSize(); }
+        size_t  GetDroppedPacketsCount() const { return m_droppedPackets; }
+
+        //! The realm accepted the session key
+        bool    IsAuthenticated() const { return m_authenticated; }
+
     private:
-        void                            HandleAuthChallenge( Network::ByteBuffer packet );
+        friend class OpcodeTable;
+
+        void                            HandleAuthChallenge( const Game::ServerAuthChallenge & challenge );
+        void                            HandleAuthResponse( const Game::ServerAuthResponse & response );
+
+        void                            HandlePacket( const OpcodeHandler & handler, Network::ByteBuffer & packet );
+
+        //! The payload is built behind room for the header, which is then written and encrypted in place
+        template< typename Schema >
+        void SendPacket( Game::ClientOpcode opcode, const typename Schema::Type & packet )
+        {
+            Network::ByteBuffer buffer = Schema::Build( packet, Game::CLIENT_HEADER_SIZE );
+            WriteHeader( buffer, opcode );
+
+            //! a failed send means the connection is already closed, see the high-water policy set in the constructor
+            static_cast< void >( SendBuffer( std::move( buffer ) ) );
+        }
+
+        void                            WriteHeader( Network::ByteBuffer & packet, Game::ClientOpcode opcode );
 
         boost::asio::awaitable<bool>    ReceivePacketAsync( std::byte header ) override;
 
-        using PacketQueue = std::deque< std::pair< Game::ServerOpcode, Network::ByteBuffer > >;
+        using QueuedPacket = std::pair< Game::ServerOpcode, Network::PooledBuffer >;
+        using PacketQueue = Network::SpscQueue< QueuedPacket, 256 >;
 
-        std::mutex                      m_mutex;
         PacketQueue                     m_queue;
+        std::atomic< size_t >           m_droppedPackets;
+        bool                            m_authenticated;
         std::optional<PacketCrypto>     m_crypto;
         const Crypto::BigNumber         m_cryptoKey;
     };
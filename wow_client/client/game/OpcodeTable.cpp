@@ -0,0 +1,18 @@
+#include "client/game/OpcodeTable.hpp"
+#include "client/game/GameSession.hpp"
+
+namespace Wow
+{
+    const OpcodeTable & OpcodeTable::Instance()
+    {
+        static const OpcodeTable table;
+        return table;
+    }
+
+    OpcodeTable::OpcodeTable()
+        : m_handlers{}
+    {
+        Register< &GameSession::HandleAuthChallenge >( Game::ServerOpcode::AuthChallenge, "SMSG_AUTH_CHALLENGE", PacketProcessing::Logic );
+        Register< &GameSession::HandleAuthResponse >( Game::ServerOpcode::AuthResponse, "SMSG_AUTH_RESPONSE", PacketProcessing::Logic );
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "client/packets/Packets.hpp"
+#include "networking/ByteBuffer.hpp"
+#include "networking/ByteBufferView.hpp"
+
+#include <array>
+#include <type_traits>
+
+namespace Wow
+{
+    class GameSession;
+
+    enum class PacketProcessing : uint8_t
+    {
+        Inline,     //! handled by the reader on the io thread, before the packet is queued
+        Logic       //! queued and handled from GameSession::Update
+    };
+
+    struct OpcodeHandler
+    {
+        //! Parses the payload and invokes the session handler, returns false for malformed packets
+        using Handler = bool ( * )( GameSession & session, Network::ByteBuffer & packet );
+
+        const char *        m_name = nullptr;
+        Handler             m_handler = nullptr;
+        PacketProcessing    m_processing = PacketProcessing::Logic;
+    };
+
+    //! Flat table indexed by the 16-bit server opcode, entries without handler are dropped and counted
+    class OpcodeTable
+    {
+    public:
+        static constexpr size_t OPCODES_COUNT = 0x10000;
+
+        static const OpcodeTable &  Instance();
+
+        const OpcodeHandler &       operator[]( Game::ServerOpcode opcode ) const
+        {
+            return m_handlers[ static_cast< uint16_t >( opcode ) ];
+        }
+
+    private:
+        OpcodeTable();
+
+        template< typename Packet >
+        struct HandlerTraits;
+
+        template< typename Packet >
+        struct HandlerTraits< void ( GameSession::* )( Packet ) >
+        {
+            using Type = std::remove_cvref_t< Packet >;
+        };
+
+        //! Handlers take the raw `Network::ByteBuffer &`, a `Network::ByteBufferView` to parse it without copies
+        //! or a POD packet struct parsed from it
+        template< auto Handler >
+        void Register( Game::ServerOpcode opcode, const char * name, PacketProcessing processing )
+        {
+            using Packet = typename HandlerTraits< decltype( Handler ) >::Type;
+
+            m_handlers[ static_cast< uint16_t >( opcode ) ] = { name, &Dispatch< Packet, Handler >, processing };
+        }
+
+        template< typename Packet, auto Handler >
+        static bool Dispatch( GameSession & session, Network::ByteBuffer & buffer )
+        {
+            if constexpr ( std::is_same_v< Packet, Network::ByteBuffer > )
+            {
+                ( session.*Handler )( buffer );
+            }
+            else if constexpr ( std::is_same_v< Packet, Network::ByteBufferView > )
+            {
+                ( session.*Handler )( Network::ByteBufferView( buffer ) );
+            }
+            else
+            {
+                auto packet = Network::ByteBufferView( buffer ).Read< Packet >();
+                if ( !packet )
+                    return false;
+
+                ( session.*Handler )( *packet );
+            }
+
+            return true;
+        }
+
+        std::array< OpcodeHandler, OPCODES_COUNT > m_handlers;
+    };
+}
@@ -3,6 +3,7 @@
 #include "crypto/Sha1.hpp"
 #include <array>
 #include "networking/ByteBuffer.hpp"
+#include "networking/PacketSchema.hpp"
 
 #pragma pack(push, 1)
 
@@ -15,18 +16,86 @@ namespace Wow
     {
         enum class ClientOpcode : uint8_t
         {
-            LogonChallenge  = 0x00,
-            LogonProof      = 0x01,
-            RealmList       = 0x10
+            LogonChallenge      = 0x00,
+            LogonProof          = 0x01,
+            ReconnectChallenge  = 0x02,
+            ReconnectProof      = 0x03,
+            RealmList           = 0x10
         };
 
         enum class ServerOpcode : uint8_t
         {
-            LogonChallenge  = 0x00,
-            LogonProof      = 0x01,
-            RealmList       = 0x10
+            LogonChallenge      = 0x00,
+            LogonProof          = 0x01,
+            ReconnectChallenge  = 0x02,
+            ReconnectProof      = 0x03,
+            RealmList           = 0x10
         };
 
+        //! Logon and reconnect challenges share the same layout
+        struct ClientLogonChallenge
+        {
+            ClientOpcode     Opcode;
+            uint8_t          MajorVersion;
+            uint8_t          MinorVersion;
+            uint8_t          PatchVersion;
+            uint16_t         BuildNumber;
+            uint32_t         LocalAddress;
+            std::string_view Username;
+        };
+
+        using ClientLogonChallengeSchema = Network::PacketSchema< ClientLogonChallenge,
+            Network::Schema::Field< &ClientLogonChallenge::Opcode >,
+            Network::Schema::Constant< uint8_t, 6 >,
+            Network::Schema::RemainingSize< uint16_t >,
+            Network::Schema::Constant< uint32_t, 'WoW' >,
+            Network::Schema::Field< &ClientLogonChallenge::MajorVersion >,
+            Network::Schema::Field< &ClientLogonChallenge::MinorVersion >,
+            Network::Schema::Field< &ClientLogonChallenge::PatchVersion >,
+            Network::Schema::Field< &ClientLogonChallenge::BuildNumber >,
+            Network::Schema::Constant< uint32_t, '68x' >,
+            Network::Schema::Constant< uint32_t, 'niW' >,
+            Network::Schema::Constant< uint32_t, 'SUne' >,
+            Network::Schema::Constant< uint32_t, 0x3c >,
+            Network::Schema::Field< &ClientLogonChallenge::LocalAddress >,
+            Network::Schema::LengthPrefixed< &ClientLogonChallenge::Username > >;
+
+        struct ClientLogonProof
+        {
+            ClientOpcode         Opcode;
+            FixedArray< 32 >     A;
+            Crypto::Sha1::Digest M1;
+        };
+
+        //! CRC hash, key count and security flags are all left empty
+        using ClientLogonProofSchema = Network::PacketSchema< ClientLogonProof,
+            Network::Schema::Field< &ClientLogonProof::Opcode >,
+            Network::Schema::Field< &ClientLogonProof::A >,
+            Network::Schema::Field< &ClientLogonProof::M1 >,
+            Network::Schema::Padding< 20 + 1 + 1 > >;
+
+        struct ClientReconnectProof
+        {
+            ClientOpcode         Opcode;
+            FixedArray< 16 >     R1;
+            Crypto::Sha1::Digest R2;
+        };
+
+        using ClientReconnectProofSchema = Network::PacketSchema< ClientReconnectProof,
+            Network::Schema::Field< &ClientReconnectProof::Opcode >,
+            Network::Schema::Field< &ClientReconnectProof::R1 >,
+            Network::Schema::Field< &ClientReconnectProof::R2 >,
+            Network::Schema::Padding< 20 + 1 > >;
+
+        struct ClientRealmListQuery
+        {
+            ClientOpcode         Opcode;
+        };
+
+        using ClientRealmListQuerySchema = Network::PacketSchema< ClientRealmListQuery,
+            Network::Schema::Field< &ClientRealmListQuery::Opcode >,
+            Network::Schema::Constant< uint32_t > >;
+
         struct ServerLogonChallenge
         {
             FixedArray< 32 > B;
@@ -47,6 +116,17 @@ namespace Wow
             uint16_t             unk3;
         };
 
+        struct ServerReconnectChallenge
+        {
+            FixedArray< 16 > Challenge;
+            FixedArray< 16 > Unk1;
+        };
+
+        struct ServerReconnectProof
+        {
+            uint16_t         Unk1;
+        };
+
         enum class RealmFlags : uint8_t
         {
             None             = 0x00,
@@ -60,20 +140,55 @@ namespace Wow
             Full             = 0x80
         };
 
+        //! Name and address borrow from the packet the info was parsed from
         struct ServerRealmInfo
         {
             uint8_t             icon;
             uint8_t             lock;
             RealmFlags          flags;
-            Network::NullString name;
-            Network::NullString address;
+            std::string_view    name;
+            std::string_view    address;
             float               populationLevel;
             uint8_t             charactersCount;
             uint8_t             timezone;
             uint8_t             realmId;
+
+            //! only sent with RealmFlags::SpecifyBuild
+            uint8_t             majorVersion;
+            uint8_t             minorVersion;
+            uint8_t             patchVersion;
+            uint16_t            buildNumber;
         };
 
         using ServerRealmList = std::vector<ServerRealmInfo>;
+
+        using ServerRealmInfoSchema = Network::PacketSchema< ServerRealmInfo,
+            Network::Schema::Field< &ServerRealmInfo::icon >,
+            Network::Schema::Field< &ServerRealmInfo::lock >,
+            Network::Schema::Field< &ServerRealmInfo::flags >,
+            Network::Schema::NullTerminated< &ServerRealmInfo::name >,
+            Network::Schema::NullTerminated< &ServerRealmInfo::address >,
+            Network::Schema::Field< &ServerRealmInfo::populationLevel >,
+            Network::Schema::Field< &ServerRealmInfo::charactersCount >,
+            Network::Schema::Field< &ServerRealmInfo::timezone >,
+            Network::Schema::Field< &ServerRealmInfo::realmId >,
+            Network::Schema::When< Network::Schema::FlagSet< &ServerRealmInfo::flags, RealmFlags::SpecifyBuild >,
+                Network::Schema::Field< &ServerRealmInfo::majorVersion >,
+                Network::Schema::Field< &ServerRealmInfo::minorVersion >,
+                Network::Schema::Field< &ServerRealmInfo::patchVersion >,
+                Network::Schema::Field< &ServerRealmInfo::buildNumber > > >;
+
+        //! Payload of the realm list, after the size
+        struct ServerRealmListPayload
+        {
+            ServerRealmList     realms;
+        };
+
+        using ServerRealmListSchema = Network::PacketSchema< ServerRealmListPayload,
+            Network::Schema::Constant< uint32_t >,
+            Network::Schema::Repeated< &ServerRealmListPayload::realms, uint16_t, ServerRealmInfoSchema >,
+            Network::Schema::Constant< uint8_t, 0x10 >,
+            Network::Schema::Constant< uint8_t > >;
     }
 
     namespace Game
@@ -86,8 +201,32 @@ namespace Wow
         enum class ServerOpcode : uint16_t
         {
             AuthChallenge       = 0x1EC,
+            AuthResponse        = 0x1EE,
         };
 
+        enum class ResponseCode : uint8_t
+        {
+            AuthOk              = 0x0C,
+            AuthFailed          = 0x0D,
+            AuthReject          = 0x0E,
+            AuthBadServerProof  = 0x0F,
+            AuthUnavailable     = 0x10,
+            AuthSystemError     = 0x11,
+            AuthUnknownAccount  = 0x15,
+            AuthSessionExpired  = 0x1B,
+        };
+
+        //! Client header: size ( 2 bytes big endian, counts the opcode ) followed by opcode ( 4 bytes little endian )
+        constexpr size_t CLIENT_HEADER_SIZE = 6;
+
+        //! Placeholder payload, nothing but the leading build field and that is left empty
+        struct ClientAuthSession
+        {
+        };
+
+        using ClientAuthSessionSchema = Network::PacketSchema< ClientAuthSession,
+            Network::Schema::Constant< uint32_t > >;
+
         struct ServerAuthChallenge
         {
             uint32_t         SeedSize;
@@ -96,6 +235,12 @@ namespace Wow
             FixedArray< 16 > Seed1;
             FixedArray< 16 > Seed2;
         };
+
+        //! Only the leading result code, the billing and queue details that follow are not needed
+        struct ServerAuthResponse
+        {
+            ResponseCode     Result;
+        };
     }
 };
 
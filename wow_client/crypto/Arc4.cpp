@@ -1,25 +1,104 @@
 #include "Arc4.hpp"
 
+#include <algorithm>
+#include <utility>
+
 namespace Crypto
 {
-    Arc4::Arc4( gsl::span< const std::byte> seed )
+    namespace
     {
-        //EVP_CIPHER_CTX_init( &m_context );
-        //EVP_EncryptInit_ex( &m_context, EVP_rc4(), nullptr, nullptr, nullptr );
-        //EVP_CIPHER_CTX_set_key_length( &m_context, seed.size() );
-        //EVP_EncryptInit_ex( &m_context, nullptr, nullptr, ( const uint8_t* )seed.data(), nullptr );
+        struct KnownAnswer
+        {
+            size_t                      m_keySize;
+            std::array< uint8_t, 24 >   m_key;
+            std::array< uint8_t, 16 >   m_offset0;
+            std::array< uint8_t, 16 >   m_offset1024;
+        };
+
+        //! RFC 6229 keystreams for 40, 128 and 192 bit keys
+        const KnownAnswer KNOWN_ANSWERS[] =
+        {
+            {
+                5,
+                { 0x01, 0x02, 0x03, 0x04, 0x05 },
+                { 0xb2, 0x39, 0x63, 0x05, 0xf0, 0x3d, 0xc0, 0x27, 0xcc, 0xc3, 0x52, 0x4a, 0x0a, 0x11, 0x18, 0xa8 },
+                { 0x30, 0xab, 0xbc, 0xc7, 0xc2, 0x0b, 0x01, 0x60, 0x9f, 0x23, 0xee, 0x2d, 0x5f, 0x6b, 0xb7, 0xdf }
+            },
+            {
+                16,
+                { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10 },
+                { 0x9a, 0xc7, 0xcc, 0x9a, 0x60, 0x9d, 0x1e, 0xf7, 0xb2, 0x93, 0x28, 0x99, 0xcd, 0xe4, 0x1b, 0x97 },
+                { 0xbd, 0xf0, 0x32, 0x4e, 0x60, 0x83, 0xdc, 0xc6, 0xd3, 0xce, 0xdd, 0x3c, 0xa8, 0xc5, 0x3c, 0x16 }
+            },
+            {
+                24,
+                { 0xc1, 0x09, 0x16, 0x39, 0x08, 0xeb, 0xe5, 0x1d, 0xeb, 0xb4, 0x62, 0x27, 0xc6, 0xcc, 0x8b, 0x37, 0x64, 0x19, 0x10, 0x83, 0x32, 0x22, 0x77, 0x2a },
+                { 0x54, 0xb6, 0x4e, 0x6b, 0x5a, 0x20, 0xb5, 0xe2, 0xec, 0x84, 0x59, 0x3d, 0xc7, 0x98, 0x9d, 0xa7 },
+                { 0xf5, 0x85, 0x4c, 0xdb, 0x76, 0xc8, 0x89, 0xe3, 0xad, 0x63, 0x35, 0x4e, 0x5f, 0x72, 0x75, 0xe3 }
+            }
+        };
+
+        //! Encrypting zeros yields the keystream itself
+        bool MatchesKeystream( Arc4 & cipher, const std::array< uint8_t, 16 > & expected )
+        {
+            std::array< std::byte, 16 > keystream{};
+            cipher.Process( keystream );
+
+            return std::equal( keystream.begin(), keystream.end(), expected.begin(), []( std::byte lhs, uint8_t rhs )
+            {
+                return static_cast< uint8_t >( lhs ) == rhs;
+            } );
+        }
     }
 
-    Arc4::~Arc4()
+    Arc4::Arc4( gsl::span< const std::byte> key )
+        : m_x( 0u )
+        , m_y( 0u )
     {
-        //EVP_CIPHER_CTX_cleanup( &m_context );
+        for ( size_t idx = 0u; idx < m_state.size(); ++idx )
+            m_state[ idx ] = static_cast< uint8_t >( idx );
+
+        if ( key.empty() )
+            return;
+
+        uint8_t j = 0u;
+        for ( size_t idx = 0u; idx < m_state.size(); ++idx )
+        {
+            j = static_cast< uint8_t >( j + m_state[ idx ] + static_cast< uint8_t >( key[ idx % key.size() ] ) );
+            std::swap( m_state[ idx ], m_state[ j ] );
+        }
     }
 
     void Arc4::Process( gsl::span<std::byte> data )
     {
-        int size = 0;
+        for ( auto & byte : data )
+            byte ^= static_cast< std::byte >( NextByte() );
+    }
+
+    void Arc4::Drop( size_t count )
+    {
+        for ( size_t idx = 0u; idx < count; ++idx )
+            NextByte();
+    }
+
+    bool Arc4::SelfTest()
+    {
+        for ( const auto & answer : KNOWN_ANSWERS )
+        {
+            const auto key = gsl::span< const std::byte >( reinterpret_cast< const std::byte * >( answer.m_key.data() ), answer.m_keySize );
+
+            Arc4 cipher( key );
+            if ( !MatchesKeystream( cipher, answer.m_offset0 ) )
+                return false;
+
+            //! the header cipher skips the same amount through Drop
+            Arc4 droppedCipher( key );
+            droppedCipher.Drop( 1024 );
+
+            if ( !MatchesKeystream( droppedCipher, answer.m_offset1024 ) )
+                return false;
+        }
 
-        //EVP_EncryptUpdate( &m_context, ( uint8_t* )data.data(), &size, ( const uint8_t* )data.data(), data.size() );
-        //EVP_EncryptFinal_ex( &m_context, ( uint8_t* )data.data(), &size );
+        return true;
     }
 }
@@ -1,19 +1,38 @@
 #pragma once
 
-#include <openssl/evp.h>
+#include <array>
+#include <cstdint>
 #include <gsl/span>
 
 namespace Crypto
 {
+    //! Table driven RC4, the whole state lives inline so a cipher never touches the heap
     class Arc4
     {
     public:
-        Arc4( gsl::span<const std::byte> data );
-        ~Arc4();
+        Arc4( gsl::span<const std::byte> key );
 
+        //! Encrypts or decrypts in place
         void            Process( gsl::span<std::byte> data );
 
+        //! Discards keystream bytes, WoW drops the first 1024
+        void            Drop( size_t count );
+
+        //! Known answer check against the RFC 6229 vectors, at the start of the keystream and after the 1024 byte drop
+        static bool     SelfTest();
+
     private:
-        //EVP_CIPHER_CTX  m_context;
+        uint8_t         NextByte()
+        {
+            m_x = static_cast< uint8_t >( m_x + 1 );
+            m_y = static_cast< uint8_t >( m_y + m_state[ m_x ] );
+
+            std::swap( m_state[ m_x ], m_state[ m_y ] );
+            return m_state[ static_cast< uint8_t >( m_state[ m_x ] + m_state[ m_y ] ) ];
+        }
+
+        std::array< uint8_t, 256 >  m_state;
+        uint8_t                     m_x;
+        uint8_t                     m_y;
     };
 }
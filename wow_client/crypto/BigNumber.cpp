@@ -2,17 +2,80 @@
 
 #include <openssl/bn.h>
 #include <openssl/crypto.h>
-#include <xutility>
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 namespace Crypto
 {
+    namespace
+    {
+        //! Scratch space for BN operations, one per thread instead of a BN_CTX_new / BN_CTX_free per call
+        struct ThreadContext
+        {
+            static constexpr size_t MAX_MONTGOMERY_CONTEXTS = 8;
+
+            ThreadContext()
+                : m_context( BN_CTX_new() )
+            {
+            }
+
+            ~ThreadContext()
+            {
+                for ( auto & [modulus, montgomery] : m_montgomery )
+                {
+                    BN_free( modulus );
+                    BN_MONT_CTX_free( montgomery );
+                }
+
+                BN_CTX_free( m_context );
+            }
+
+            //! Logins against the same server always use the same N, so its Montgomery setup is done once per thread
+            BN_MONT_CTX * GetMontgomeryContext( const BIGNUM * modulus )
+            {
+                for ( auto & [cachedModulus, montgomery] : m_montgomery )
+                {
+                    if ( BN_cmp( cachedModulus, modulus ) == 0 )
+                        return montgomery;
+                }
+
+                BN_MONT_CTX * montgomery = BN_MONT_CTX_new();
+                if ( !BN_MONT_CTX_set( montgomery, modulus, m_context ) )
+                {
+                    BN_MONT_CTX_free( montgomery );
+                    return nullptr;
+                }
+
+                if ( m_montgomery.size() == MAX_MONTGOMERY_CONTEXTS )
+                {
+                    BN_free( m_montgomery.front().first );
+                    BN_MONT_CTX_free( m_montgomery.front().second );
+                    m_montgomery.erase( m_montgomery.begin() );
+                }
+
+                m_montgomery.emplace_back( BN_dup( modulus ), montgomery );
+                return montgomery;
+            }
+
+            BN_CTX *                                            m_context;
+            std::vector< std::pair< BIGNUM *, BN_MONT_CTX * > > m_montgomery;
+        };
+
+        ThreadContext & GetThreadContext()
+        {
+            thread_local ThreadContext context;
+            return context;
+        }
+    }
+
     BigNumber::BigNumber()
         : m_impl( BN_new() )
     {
     }
 
     BigNumber::BigNumber( BigNumber const & bn )
-        : m_impl( BN_dup( bn.m_impl ) )
+        : m_impl( BN_dup( bn.GetImpl() ) )
     {
     }
 
@@ -25,10 +88,12 @@ namespace Crypto
     BigNumber::BigNumber( gsl::span< const std::byte > data )
         : m_impl( BN_new() )
     {
-        std::vector< std::byte > buffer;
-        buffer.insert( buffer.end(), data.rbegin(), data.rend() );
+        BN_lebin2bn( reinterpret_cast< const uint8_t* >( data.data() ), ( int )data.size(), m_impl );
+    }
 
-        BN_bin2bn( reinterpret_cast< const uint8_t* >( buffer.data() ), ( int )buffer.size(), m_impl );
+    BigNumber::BigNumber( BigNumber && bn ) noexcept
+        : m_impl( std::exchange( bn.m_impl, nullptr ) )
+    {
     }
 
     BigNumber::~BigNumber()
@@ -36,6 +101,21 @@ namespace Crypto
         BN_free( m_impl );
     }
 
+    bignum_st * BigNumber::GetImpl()
+    {
+        if ( m_impl == nullptr )
+            m_impl = BN_new();
+
+        return m_impl;
+    }
+
+    const bignum_st * BigNumber::GetImpl() const
+    {
+        static const BIGNUM * const zero = BN_new();
+
+        return m_impl != nullptr ? m_impl : zero;
+    }
+
     BigNumber & BigNumber::operator=( BigNumber const & bn )
     {
         if ( this == &bn )
@@ -43,132 +123,181 @@ namespace Crypto
 
         if ( m_impl == nullptr )
         {
-            m_impl = BN_dup( bn.m_impl );
+            m_impl = BN_dup( bn.GetImpl() );
         }
         else
         {
-            BN_copy( m_impl, bn.m_impl );
+            BN_copy( m_impl, bn.GetImpl() );
         }
         return *this;
     }
 
+    BigNumber & BigNumber::operator=( BigNumber && bn ) noexcept
+    {
+        std::swap( m_impl, bn.m_impl );
+        return *this;
+    }
+
     BigNumber::operator uint32_t() const
     {
-        return ( uint32_t ) BN_get_word( m_impl );
+        return ( uint32_t ) BN_get_word( GetImpl() );
     }
 
     void BigNumber::Randomize( uint8_t bytes )
     {
-        BN_rand( m_impl, bytes * 8, 0, 1 );
+        BN_rand( GetImpl(), bytes * 8, 0, 1 );
     }
 
     BigNumber& BigNumber::operator+=( BigNumber const & bn )
     {
-        BN_add( m_impl, m_impl, bn.m_impl );
+        bignum_st * impl = GetImpl();
+        BN_add( impl, impl, bn.GetImpl() );
         return *this;
     }
 
-    BigNumber BigNumber::operator+( BigNumber const & bn ) const
+    BigNumber BigNumber::operator+( BigNumber const & bn ) const &
     {
         BigNumber t( *this );
-        return t += bn;
+        t += bn;
+        return t;
+    }
+
+    BigNumber BigNumber::operator+( BigNumber const & bn ) &&
+    {
+        *this += bn;
+        return std::move( *this );
     }
 
     BigNumber& BigNumber::operator-=( BigNumber const & bn )
     {
-        BN_sub( m_impl, m_impl, bn.m_impl );
+        bignum_st * impl = GetImpl();
+        BN_sub( impl, impl, bn.GetImpl() );
         return *this;
     }
 
-    BigNumber BigNumber::operator-( BigNumber const & bn ) const
+    BigNumber BigNumber::operator-( BigNumber const & bn ) const &
     {
         BigNumber t( *this );
-        return t -= bn;
+        t -= bn;
+        return t;
+    }
+
+    BigNumber BigNumber::operator-( BigNumber const & bn ) &&
+    {
+        *this -= bn;
+        return std::move( *this );
     }
 
     BigNumber& BigNumber::operator*=( BigNumber const & bn )
     {
-        BN_CTX * bnctx = BN_CTX_new();
-        BN_mul( m_impl, m_impl, bn.m_impl, bnctx );
-        BN_CTX_free( bnctx );
+        bignum_st * impl = GetImpl();
+        BN_mul( impl, impl, bn.GetImpl(), GetThreadContext().m_context );
 
         return *this;
     }
 
-    BigNumber BigNumber::operator*( BigNumber const & bn ) const
+    BigNumber BigNumber::operator*( BigNumber const & bn ) const &
     {
         BigNumber t( *this );
-        return t *= bn;
+        t *= bn;
+        return t;
+    }
+
+    BigNumber BigNumber::operator*( BigNumber const & bn ) &&
+    {
+        *this *= bn;
+        return std::move( *this );
     }
 
     BigNumber& BigNumber::operator/=( BigNumber const & bn )
     {
-        BN_CTX * bnctx = BN_CTX_new();
-        BN_div( m_impl, NULL, m_impl, bn.m_impl, bnctx );
-        BN_CTX_free( bnctx );
+        bignum_st * impl = GetImpl();
+        BN_div( impl, NULL, impl, bn.GetImpl(), GetThreadContext().m_context );
 
         return *this;
     }
 
-    BigNumber BigNumber::operator/( BigNumber const & bn ) const
+    BigNumber BigNumber::operator/( BigNumber const & bn ) const &
     {
         BigNumber t( *this );
-        return t /= bn;
+        t /= bn;
+        return t;
+    }
+
+    BigNumber BigNumber::operator/( BigNumber const & bn ) &&
+    {
+        *this /= bn;
+        return std::move( *this );
     }
 
     BigNumber& BigNumber::operator%=( BigNumber const & bn )
     {
-        BN_CTX * bnctx = BN_CTX_new();
-        BN_mod( m_impl, m_impl, bn.m_impl, bnctx );
-        BN_CTX_free( bnctx );
+        bignum_st * impl = GetImpl();
+        BN_mod( impl, impl, bn.GetImpl(), GetThreadContext().m_context );
 
         return *this;
     }
 
-    BigNumber BigNumber::operator%( BigNumber const & bn ) const
+    BigNumber BigNumber::operator%( BigNumber const & bn ) const &
     {
         BigNumber t( *this );
-        return t %= bn;
+        t %= bn;
+        return t;
+    }
+
+    BigNumber BigNumber::operator%( BigNumber const & bn ) &&
+    {
+        *this %= bn;
+        return std::move( *this );
     }
 
     std::vector<std::byte> BigNumber::GetBytes( size_t minSize ) const
     {
-        size_t numBytes = BN_num_bytes( m_impl );
-        size_t size = ( minSize >= numBytes ) ? minSize : numBytes;
+        std::vector<std::byte> bytes( std::max( minSize, GetNumBytes() ) );
+        ToBytes( bytes );
 
-        std::vector<std::byte> bytes;
-        bytes.resize( size, std::byte{} );
+        return bytes;
+    }
 
-        BN_bn2bin( m_impl, reinterpret_cast< uint8_t * >( bytes.data() ) );
-        std::reverse( bytes.begin(), bytes.end() );
+    bool BigNumber::ToBytes( gsl::span< std::byte > bytes ) const
+    {
+        return BN_bn2lebinpad( GetImpl(), reinterpret_cast< uint8_t * >( bytes.data() ), ( int )bytes.size() ) >= 0;
+    }
 
-        return bytes;
+    size_t BigNumber::GetNumBytes() const
+    {
+        return BN_num_bytes( GetImpl() );
     }
 
     BigNumber BigNumber::Exp( BigNumber const & bn )
     {
         BigNumber ret;
-        BN_CTX * bnctx;
-
-        bnctx = BN_CTX_new();
-        BN_exp( ret.m_impl, m_impl, bn.m_impl, bnctx );
-        BN_CTX_free( bnctx );
+        BN_exp( ret.m_impl, GetImpl(), bn.GetImpl(), GetThreadContext().m_context );
 
         return ret;
     }
 
     bool BigNumber::IsZero() const
     {
-        return BN_is_zero( m_impl );
+        return BN_is_zero( GetImpl() );
     }
 
     BigNumber BigNumber::ModExp( BigNumber const & bn1, BigNumber const & bn2 ) const
     {
         BigNumber ret;
 
-        BN_CTX * bnctx = BN_CTX_new();
-        BN_mod_exp( ret.m_impl, m_impl, bn1.m_impl, bn2.m_impl, bnctx );
-        BN_CTX_free( bnctx );
+        auto & context = GetThreadContext();
+
+        //! SRP6 exponents are secrets, use the fixed window constant time ladder with the cached Montgomery setup of N
+        BN_MONT_CTX * montgomery = BN_is_odd( bn2.GetImpl() ) ? context.GetMontgomeryContext( bn2.GetImpl() ) : nullptr;
+        if ( montgomery )
+        {
+            BN_mod_exp_mont_consttime( ret.m_impl, GetImpl(), bn1.GetImpl(), bn2.GetImpl(), context.m_context, montgomery );
+        }
+        else
+        {
+            BN_mod_exp( ret.m_impl, GetImpl(), bn1.GetImpl(), bn2.GetImpl(), context.m_context );
+        }
 
         return ret;
     }
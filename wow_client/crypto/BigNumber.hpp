@@ -2,7 +2,9 @@
 
 #include <vector>
 #include <array>
+#include <cstdint>
 #include <gsl/span>
+#include <optional>
 
 struct bignum_st;
 
@@ -16,44 +18,53 @@ namespace Crypto
         BigNumber( gsl::span< const std::byte > data );
 
         BigNumber( BigNumber const & bn );
+        BigNumber( BigNumber && bn ) noexcept;
 
         ~BigNumber();
 
         operator uint32_t() const;
 
         BigNumber & operator=( BigNumber const & bn );
+        BigNumber & operator=( BigNumber && bn ) noexcept;
 
         BigNumber& operator+=( BigNumber const & bn );
-        BigNumber operator+( BigNumber const & bn ) const;
+        BigNumber operator+( BigNumber const & bn ) const &;
+        BigNumber operator+( BigNumber const & bn ) &&;
 
         BigNumber& operator-=( BigNumber const & bn );
-        BigNumber operator-( BigNumber const & bn ) const;
+        BigNumber operator-( BigNumber const & bn ) const &;
+        BigNumber operator-( BigNumber const & bn ) &&;
 
         BigNumber& operator*=( BigNumber const & bn );
-        BigNumber operator*( BigNumber const & bn ) const;
+        BigNumber operator*( BigNumber const & bn ) const &;
+        BigNumber operator*( BigNumber const & bn ) &&;
 
         BigNumber& operator/=( BigNumber const & bn );
-        BigNumber operator/( BigNumber const & bn ) const;
+        BigNumber operator/( BigNumber const & bn ) const &;
+        BigNumber operator/( BigNumber const & bn ) &&;
 
         BigNumber& operator%=( BigNumber const & bn );
-        BigNumber operator%( BigNumber const & bn ) const;
+        BigNumber operator%( BigNumber const & bn ) const &;
+        BigNumber operator%( BigNumber const & bn ) &&;
 
+        //! Little endian, zero padded to N bytes, empty when the number does not fit
         template< size_t N >
-        std::array< std::byte, N > GetFixedBytes() const
+        std::optional< std::array< std::byte, N > > GetFixedBytes() const
         {
-            std::array< std::byte, N > result;
-
-            auto bytes = GetBytes( N );
-            for ( int idx = 0u; idx < N; ++idx )
-            {
-                result[ idx ] = bytes[ idx ];
-            }
+            std::array< std::byte, N > result{};
+            if ( !ToBytes( result ) )
+                return std::nullopt;
 
             return result;
         }
 
+        //! Little endian, zero padded up to `minSize`
         std::vector<std::byte> GetBytes( size_t minSize = 0 ) const;
 
+        //! Writes little endian bytes zero padded to the whole span, fails when the span is too small
+        bool        ToBytes( gsl::span< std::byte > bytes ) const;
+        size_t      GetNumBytes() const;
+
         BigNumber   ModExp( BigNumber const & bn1, BigNumber const & bn2 ) const;
         BigNumber   Exp( BigNumber const & );
         void        Randomize( uint8_t bytes );
@@ -61,6 +72,10 @@ namespace Crypto
         bool        IsZero() const;
 
     private:
+        //! A moved-from number owns nothing, it reads as zero and allocates again once it is written to
+        bignum_st *         GetImpl();
+        const bignum_st *   GetImpl() const;
+
         bignum_st * m_impl;
     };
 }
\ No newline at end of file
@@ -1,29 +1,46 @@
-//#include "HmacHash.hpp"
+#include "HmacHash.hpp"
+
+#include <cstring>
 
 namespace Crypto
 {
-    HmacHash::HmacHash( gsl::span< const std::byte > seed )
+    HmacHash::HmacHash( gsl::span< const std::byte > key )
     {
-        //HMAC_CTX_init( &m_context );
-        //HMAC_Init_ex( &m_context,  (const uint8_t* )seed.data(), seed.size(), EVP_sha1(), nullptr );
-    }
+        std::array< uint8_t, SHA_CBLOCK > block = {};
 
-    HmacHash::~HmacHash()
-    {
-        //HMAC_CTX_cleanup( &m_context );
+        //! keys longer than a block are hashed first
+        if ( key.size() > block.size() )
+            SHA1( reinterpret_cast< const uint8_t* >( key.data() ), key.size(), block.data() );
+        else if ( !key.empty() )
+            std::memcpy( block.data(), key.data(), key.size() );
+
+        std::array< uint8_t, SHA_CBLOCK > pad;
+
+        for ( size_t idx = 0u; idx < block.size(); ++idx )
+            pad[ idx ] = block[ idx ] ^ 0x36;
+
+        SHA1_Init( &m_inner );
+        SHA1_Update( &m_inner, pad.data(), pad.size() );
+
+        for ( size_t idx = 0u; idx < block.size(); ++idx )
+            pad[ idx ] = block[ idx ] ^ 0x5C;
+
+        SHA1_Init( &m_outer );
+        SHA1_Update( &m_outer, pad.data(), pad.size() );
     }
 
-    HmacHash::Digest HmacHash::ComputeHash( gsl::span< const std::byte > data )
+    HmacHash::Digest HmacHash::ComputeHash( gsl::span< const std::byte > data ) const
     {
-        //HMAC_Update( &m_context, ( const uint8_t* )data.data(), data.size() );
-        //
-        //Digest result = {};
-        //
-        //uint32_t length = 0u;
-        //HMAC_Final( &m_context, ( uint8_t* )result.data(), &length );
-        //
-        //return result;
-        Digest result{};
+        Digest result = {};
+
+        SHA_CTX context = m_inner;
+        SHA1_Update( &context, data.data(), data.size() );
+        SHA1_Final( reinterpret_cast< uint8_t* >( result.data() ), &context );
+
+        context = m_outer;
+        SHA1_Update( &context, result.data(), result.size() );
+        SHA1_Final( reinterpret_cast< uint8_t* >( result.data() ), &context );
+
         return result;
     }
 }
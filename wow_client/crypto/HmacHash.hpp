@@ -1,22 +1,24 @@
 #pragma once
 
-//#include <openssl/hmac.h>
-//#include <openssl/sha.h>
+#include <openssl/sha.h>
+#include <array>
 #include <gsl/span>
 
 namespace Crypto
 {
+    //! HMAC-SHA1, the key is absorbed once into the inner and outer states in the constructor
+    //! so every ComputeHash only runs the compression function over the message and the inner digest
     class HmacHash
     {
     public:
-        HmacHash( gsl::span< const std::byte > seed );
-        ~HmacHash();
+        HmacHash( gsl::span< const std::byte > key );
 
         using Digest = std::array<std::byte, SHA_DIGEST_LENGTH>;
 
-        Digest      ComputeHash( gsl::span< const std::byte > data );
+        Digest      ComputeHash( gsl::span< const std::byte > data ) const;
 
     private:
-        //HMAC_CTX    m_context;
+        SHA_CTX     m_inner;
+        SHA_CTX     m_outer;
     };
 }
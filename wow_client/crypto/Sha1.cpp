@@ -1,5 +1,22 @@
 #include "Sha1.hpp"
 
+#include <algorithm>
+#include <cstring>
+
+#if defined( _M_X64 ) || defined( __x86_64__ )
+    #define SHA1_HAS_AVX2_LANES
+
+    #include <immintrin.h>
+
+    #if defined( _MSC_VER )
+        #include <intrin.h>
+        #define SHA1_TARGET_AVX2
+    #else
+        #include <cpuid.h>
+        #define SHA1_TARGET_AVX2 __attribute__( ( target( "avx2" ) ) )
+    #endif
+#endif
+
 namespace Crypto
 {
     Sha1::Sha1()
@@ -15,7 +32,17 @@ namespace Crypto
 
     void Sha1::UpdateData( const BigNumber & bn )
     {
-        UpdateData( bn.GetBytes() );
+        const size_t size = bn.GetNumBytes();
+        if ( size > MAX_STACK_BIGNUMBER_SIZE )
+        {
+            UpdateData( bn.GetBytes() );
+            return;
+        }
+
+        std::array< std::byte, MAX_STACK_BIGNUMBER_SIZE > bytes;
+        bn.ToBytes( { bytes.data(), size } );
+
+        UpdateData( gsl::span< const std::byte >( bytes.data(), size ) );
     }
 
     void Sha1::UpdateData( std::string_view data )
@@ -40,4 +67,211 @@ namespace Crypto
 
         return m_digest;
     }
+
+#if defined( SHA1_HAS_AVX2_LANES )
+    namespace
+    {
+        constexpr size_t LANES_COUNT = 8;
+        constexpr size_t BLOCK_SIZE = 64;
+
+        enum class BatchPath
+        {
+            Sequential,     //! OpenSSL one message at a time, picks SHA-NI on its own
+            Avx2Lanes
+        };
+
+        BatchPath DetectBatchPath()
+        {
+#if defined( _MSC_VER )
+            int info[ 4 ];
+            __cpuid( info, 0 );
+            if ( info[ 0 ] < 7 )
+                return BatchPath::Sequential;
+
+            __cpuid( info, 1 );
+            const bool hasOsXsave = ( info[ 2 ] & ( 1 << 27 ) ) != 0;
+
+            __cpuidex( info, 7, 0 );
+            const bool hasSha = ( info[ 1 ] & ( 1 << 29 ) ) != 0;
+
+            //! the OS has to save the ymm registers on context switches
+            const bool hasAvx2 = ( info[ 1 ] & ( 1 << 5 ) ) != 0 && hasOsXsave && ( _xgetbv( 0 ) & 0x6 ) == 0x6;
+#else
+            unsigned eax, ebx, ecx, edx;
+            if ( !__get_cpuid_count( 7, 0, &eax, &ebx, &ecx, &edx ) )
+                return BatchPath::Sequential;
+
+            const bool hasSha = ( ebx & ( 1u << 29 ) ) != 0;
+
+            //! also checks that the OS saves the ymm registers
+            const bool hasAvx2 = __builtin_cpu_supports( "avx2" );
+#endif
+            //! a single SHA-NI stream is already faster than a lane of the AVX2 pass
+            if ( hasSha || !hasAvx2 )
+                return BatchPath::Sequential;
+
+            return BatchPath::Avx2Lanes;
+        }
+
+        //! Block `block` of the message after SHA-1 padding, as big endian words
+        void LoadPaddedBlock( gsl::span< const std::byte > message, size_t block, size_t blocksCount, uint32_t ( & words )[ 16 ] )
+        {
+            std::array< uint8_t, BLOCK_SIZE > bytes{};
+
+            const size_t offset = block * BLOCK_SIZE;
+            if ( offset < message.size() )
+                std::memcpy( bytes.data(), message.data() + offset, std::min( BLOCK_SIZE, message.size() - offset ) );
+
+            if ( message.size() >= offset && message.size() < offset + BLOCK_SIZE )
+                bytes[ message.size() - offset ] = 0x80;
+
+            if ( block + 1 == blocksCount )
+            {
+                const uint64_t bitsCount = static_cast< uint64_t >( message.size() ) * 8u;
+                for ( size_t idx = 0; idx < 8; ++idx )
+                    bytes[ BLOCK_SIZE - 1 - idx ] = static_cast< uint8_t >( bitsCount >> ( idx * 8 ) );
+            }
+
+            for ( size_t idx = 0; idx < 16; ++idx )
+                words[ idx ] = uint32_t( bytes[ idx * 4 ] ) << 24 | uint32_t( bytes[ idx * 4 + 1 ] ) << 16 | uint32_t( bytes[ idx * 4 + 2 ] ) << 8 | bytes[ idx * 4 + 3 ];
+        }
+
+        SHA1_TARGET_AVX2 inline __m256i RotateLeft( __m256i value, int bits )
+        {
+            return _mm256_or_si256( _mm256_slli_epi32( value, bits ), _mm256_srli_epi32( value, 32 - bits ) );
+        }
+
+        //! One compression of every lane, lanes outside `active` keep their state
+        SHA1_TARGET_AVX2 void CompressLanes( __m256i ( & state )[ 5 ], const uint32_t ( & words )[ 16 ][ LANES_COUNT ], __m256i active )
+        {
+            __m256i w[ 16 ];
+            for ( size_t idx = 0; idx < 16; ++idx )
+                w[ idx ] = _mm256_loadu_si256( reinterpret_cast< const __m256i * >( words[ idx ] ) );
+
+            __m256i a = state[ 0 ], b = state[ 1 ], c = state[ 2 ], d = state[ 3 ], e = state[ 4 ];
+
+            for ( size_t round = 0; round < 80; ++round )
+            {
+                __m256i wt;
+                if ( round < 16 )
+                {
+                    wt = w[ round ];
+                }
+                else
+                {
+                    wt = _mm256_xor_si256( _mm256_xor_si256( w[ ( round - 3 ) & 15 ], w[ ( round - 8 ) & 15 ] ), _mm256_xor_si256( w[ ( round - 14 ) & 15 ], w[ round & 15 ] ) );
+                    wt = RotateLeft( wt, 1 );
+                    w[ round & 15 ] = wt;
+                }
+
+                __m256i f, k;
+                if ( round < 20 )
+                {
+                    f = _mm256_xor_si256( d, _mm256_and_si256( b, _mm256_xor_si256( c, d ) ) );
+                    k = _mm256_set1_epi32( 0x5A827999 );
+                }
+                else if ( round < 40 )
+                {
+                    f = _mm256_xor_si256( _mm256_xor_si256( b, c ), d );
+                    k = _mm256_set1_epi32( 0x6ED9EBA1 );
+                }
+                else if ( round < 60 )
+                {
+                    f = _mm256_or_si256( _mm256_and_si256( b, c ), _mm256_and_si256( d, _mm256_or_si256( b, c ) ) );
+                    k = _mm256_set1_epi32( static_cast< int >( 0x8F1BBCDC ) );
+                }
+                else
+                {
+                    f = _mm256_xor_si256( _mm256_xor_si256( b, c ), d );
+                    k = _mm256_set1_epi32( static_cast< int >( 0xCA62C1D6 ) );
+                }
+
+                const __m256i temp = _mm256_add_epi32( _mm256_add_epi32( RotateLeft( a, 5 ), f ), _mm256_add_epi32( _mm256_add_epi32( e, k ), wt ) );
+                e = d;
+                d = c;
+                c = RotateLeft( b, 30 );
+                b = a;
+                a = temp;
+            }
+
+            const __m256i rounds[ 5 ] = { a, b, c, d, e };
+            for ( size_t idx = 0; idx < 5; ++idx )
+                state[ idx ] = _mm256_blendv_epi8( state[ idx ], _mm256_add_epi32( state[ idx ], rounds[ idx ] ), active );
+        }
+
+        //! Up to LANES_COUNT messages, lanes of shorter messages idle once their last block is in
+        SHA1_TARGET_AVX2 void HashLanes( gsl::span< const gsl::span< const std::byte > > messages, gsl::span< Sha1::Digest > digests )
+        {
+            size_t blocksCounts[ LANES_COUNT ] = {};
+            size_t maxBlocksCount = 0;
+            for ( size_t lane = 0; lane < messages.size(); ++lane )
+            {
+                blocksCounts[ lane ] = ( messages[ lane ].size() + 8 ) / BLOCK_SIZE + 1;
+                maxBlocksCount = std::max( maxBlocksCount, blocksCounts[ lane ] );
+            }
+
+            __m256i state[ 5 ] =
+            {
+                _mm256_set1_epi32( 0x67452301 ),
+                _mm256_set1_epi32( static_cast< int >( 0xEFCDAB89 ) ),
+                _mm256_set1_epi32( static_cast< int >( 0x98BADCFE ) ),
+                _mm256_set1_epi32( 0x10325476 ),
+                _mm256_set1_epi32( static_cast< int >( 0xC3D2E1F0 ) )
+            };
+
+            for ( size_t block = 0; block < maxBlocksCount; ++block )
+            {
+                alignas( 32 ) uint32_t words[ 16 ][ LANES_COUNT ] = {};
+                alignas( 32 ) uint32_t active[ LANES_COUNT ] = {};
+
+                for ( size_t lane = 0; lane < messages.size(); ++lane )
+                {
+                    if ( block >= blocksCounts[ lane ] )
+                        continue;
+
+                    uint32_t laneWords[ 16 ];
+                    LoadPaddedBlock( messages[ lane ], block, blocksCounts[ lane ], laneWords );
+
+                    for ( size_t idx = 0; idx < 16; ++idx )
+                        words[ idx ][ lane ] = laneWords[ idx ];
+
+                    active[ lane ] = ~0u;
+                }
+
+                CompressLanes( state, words, _mm256_load_si256( reinterpret_cast< const __m256i * >( active ) ) );
+            }
+
+            for ( size_t idx = 0; idx < 5; ++idx )
+            {
+                alignas( 32 ) uint32_t values[ LANES_COUNT ];
+                _mm256_store_si256( reinterpret_cast< __m256i * >( values ), state[ idx ] );
+
+                for ( size_t lane = 0; lane < messages.size(); ++lane )
+                {
+                    for ( size_t byte = 0; byte < 4; ++byte )
+                        digests[ lane ][ idx * 4 + byte ] = static_cast< std::byte >( values[ lane ] >> ( 24 - byte * 8 ) );
+                }
+            }
+        }
+    }
+#endif
+
+    void Sha1::CalculateHashBatch( gsl::span< const gsl::span< const std::byte > > messages, gsl::span< Digest > digests )
+    {
+        size_t first = 0;
+
+#if defined( SHA1_HAS_AVX2_LANES )
+        static const BatchPath path = DetectBatchPath();
+
+        //! a pass costs the same with idle lanes, only full groups are faster than hashing one after another
+        if ( path == BatchPath::Avx2Lanes )
+        {
+            for ( ; first + LANES_COUNT <= messages.size(); first += LANES_COUNT )
+                HashLanes( messages.subspan( first, LANES_COUNT ), digests.subspan( first, LANES_COUNT ) );
+        }
+#endif
+
+        for ( size_t idx = first; idx < messages.size(); ++idx )
+            digests[ idx ] = CalculateHash( messages[ idx ] );
+    }
 }
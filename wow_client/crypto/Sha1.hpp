@@ -4,6 +4,7 @@
 
 #include <openssl/sha.h>
 #include <array>
+#include <gsl/span>
 #include <string>
 
 namespace Crypto
@@ -25,7 +26,14 @@ namespace Crypto
             return sha1.Finalize();
         }
 
+        //! Hashes independent messages side by side, eight per pass in AVX2 lanes. The remainder, CPUs with SHA-NI
+        //! and those without AVX2 go one after another through OpenSSL. `digests` holds one entry per message
+        static void CalculateHashBatch( gsl::span< const gsl::span< const std::byte > > messages, gsl::span< Digest > digests );
+
     private:
+        //! Big enough for every SRP6 value, larger numbers fall back to a heap buffer
+        static constexpr size_t MAX_STACK_BIGNUMBER_SIZE = 128;
+
         template< typename ...T >
         void UpdateMultiData( T && ... data )
         {
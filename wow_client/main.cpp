@@ -1,14 +1,33 @@
-#include "client/GameClient.hpp"
+#include "client/Fleet.hpp"
+#include "crypto/Arc4.hpp"
 
 #include <boost/program_options.hpp>
 #include <iostream>
+#include <thread>
 
 int main( int argc, char * argv[] )
 {
+    const size_t defaultThreads = std::max( std::thread::hardware_concurrency(), 1u );
+
     boost::program_options::options_description desc( "Usage" );
     desc.add_options()( "realmlist,r", boost::program_options::value<std::string>()->required(), "Realmlist ( 127.0.0.1:3724 )" );
-    desc.add_options()( "username,u", boost::program_options::value<std::string>()->required(), "Username" );
-    desc.add_options()( "password,p", boost::program_options::value<std::string>()->required(), "Password" );
+    desc.add_options()( "username,u", boost::program_options::value<std::string>(), "Username" );
+    desc.add_options()( "password,p", boost::program_options::value<std::string>(), "Password" );
+    desc.add_options()( "accounts,a", boost::program_options::value<std::string>(), "Accounts file with `username:password` per line ( fleet mode )" );
+    desc.add_options()( "credential-cache,c", boost::program_options::value<std::string>(), "File to keep precomputed SRP6 verifiers between runs, created readable by the current user only: like a server account database it allows offline password guessing ( fleet mode )" );
+    desc.add_options()( "session-store,s", boost::program_options::value<std::string>(), "File to keep session keys between runs, restarted bots resume still valid sessions. Created readable by the current user only: until they expire the keys log in as the accounts ( fleet mode )" );
+    desc.add_options()( "session-ttl", boost::program_options::value<uint32_t>()->default_value( 900 ), "Seconds a stored session is considered valid" );
+    desc.add_options()( "login-rate", boost::program_options::value<double>()->default_value( 0.0 ), "Maximum logins per second across the fleet, 0 is unlimited" );
+    desc.add_options()( "login-burst", boost::program_options::value<uint32_t>()->default_value( 1u ), "Logins allowed at once after the fleet was idle" );
+    desc.add_options()( "login-jitter", boost::program_options::value<uint32_t>()->default_value( 0u ), "Random delay in milliseconds added to every login" );
+    desc.add_options()( "login-ramp", boost::program_options::value<std::string>()->default_value( "linear" ), "Login rate ramp up profile ( linear, step, spike )" );
+    desc.add_options()( "login-ramp-time", boost::program_options::value<uint32_t>()->default_value( 0u ), "Seconds until the login rate reaches its maximum" );
+    desc.add_options()( "realm", boost::program_options::value<std::string>(), "Only log in to the realm with this name" );
+    desc.add_options()( "realm-latency-weight", boost::program_options::value<double>()->default_value( 1.0 ), "Realm score per millisecond of connect time, lower scores are preferred" );
+    desc.add_options()( "realm-population-weight", boost::program_options::value<double>()->default_value( 10.0 ), "Realm score per population level" );
+    desc.add_options()( "realm-spread", boost::program_options::bool_switch(), "Spread bots over all usable realms weighted by score instead of picking the best one" );
+    desc.add_options()( "send-high-water-mark", boost::program_options::value<size_t>()->default_value( 256 * 1024 ), "Queued outgoing bytes per connection before it is dropped" );
+    desc.add_options()( "threads,t", boost::program_options::value<size_t>()->default_value( defaultThreads ), "Number of io shards ( fleet mode )" );
 
     auto options = boost::program_options::parse_command_line( argc, argv, desc );
 
@@ -25,10 +44,60 @@ int main( int argc, char * argv[] )
         return -1;
     }
 
-    const std::string realmlist = vm[ "realmlist" ].as<std::string>();
-    const std::string username = vm[ "username" ].as<std::string>();
-    const std::string password = vm[ "password" ].as<std::string>();
+    std::vector< Wow::Account > accounts;
+    if ( vm.count( "accounts" ) )
+    {
+        accounts = Wow::LoadAccounts( vm[ "accounts" ].as<std::string>() );
+    }
+    else if ( vm.count( "username" ) && vm.count( "password" ) )
+    {
+        accounts.push_back( { vm[ "username" ].as<std::string>(), vm[ "password" ].as<std::string>() } );
+    }
+    else
+    {
+        desc.print( std::cout );
+        return -1;
+    }
+
+    Wow::FleetOptions fleetOptions;
+    fleetOptions.m_realmlist = vm[ "realmlist" ].as<std::string>();
+    fleetOptions.m_shardsCount = vm[ "threads" ].as<size_t>();
+    fleetOptions.m_sessionTtl = std::chrono::seconds( vm[ "session-ttl" ].as<uint32_t>() );
+    fleetOptions.m_sendHighWaterMark = vm[ "send-high-water-mark" ].as<size_t>();
+
+    auto & throttleOptions = fleetOptions.m_loginThrottle;
+    throttleOptions.m_loginsPerSecond = vm[ "login-rate" ].as<double>();
+    throttleOptions.m_burst = vm[ "login-burst" ].as<uint32_t>();
+    throttleOptions.m_jitter = std::chrono::milliseconds( vm[ "login-jitter" ].as<uint32_t>() );
+    throttleOptions.m_rampTime = std::chrono::seconds( vm[ "login-ramp-time" ].as<uint32_t>() );
+
+    if ( !Wow::ParseRampProfile( vm[ "login-ramp" ].as<std::string>(), throttleOptions.m_ramp ) )
+    {
+        desc.print( std::cout );
+        return -1;
+    }
+
+    auto & selectorOptions = fleetOptions.m_realmSelector;
+    selectorOptions.m_latencyWeight = vm[ "realm-latency-weight" ].as<double>();
+    selectorOptions.m_populationWeight = vm[ "realm-population-weight" ].as<double>();
+    selectorOptions.m_spread = vm[ "realm-spread" ].as<bool>();
+
+    if ( vm.count( "realm" ) )
+        selectorOptions.m_realmName = vm[ "realm" ].as<std::string>();
+
+    if ( vm.count( "credential-cache" ) )
+        fleetOptions.m_credentialCachePath = vm[ "credential-cache" ].as<std::string>();
+
+    if ( vm.count( "session-store" ) )
+        fleetOptions.m_sessionStorePath = vm[ "session-store" ].as<std::string>();
+
+    //! a broken header cipher would only show up as realms silently dropping every bot
+    if ( !Crypto::Arc4::SelfTest() )
+    {
+        std::cerr << "[ERROR] RC4 known answer check failed\n";
+        return -1;
+    }
 
-    Wow::GameClient client;
-    return client.RunService( realmlist, username, password );
+    Wow::Fleet fleet( fleetOptions );
+    return fleet.RunService( accounts );
 }
@@ -0,0 +1,89 @@
+#include "networking/AllocationCounter.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local uint64_t allocationsCount = 0u;
+
+    void * Allocate( std::size_t size, std::size_t alignment )
+    {
+        ++allocationsCount;
+
+        //! zero sized allocations still return a unique pointer, aligned_alloc also wants a multiple of the alignment
+        size = std::max< std::size_t >( size, 1u );
+        if ( alignment != 0u )
+            size = ( size + alignment - 1u ) / alignment * alignment;
+
+        for ( ;; )
+        {
+#if defined( _MSC_VER )
+            void * ptr = alignment != 0u ? _aligned_malloc( size, alignment ) : std::malloc( size );
+#else
+            void * ptr = alignment != 0u ? std::aligned_alloc( alignment, size ) : std::malloc( size );
+#endif
+            if ( ptr )
+                return ptr;
+
+            auto handler = std::get_new_handler();
+            if ( !handler )
+                throw std::bad_alloc();
+
+            handler();
+        }
+    }
+
+    void Free( void * ptr, bool isAligned )
+    {
+#if defined( _MSC_VER )
+        if ( isAligned )
+        {
+            _aligned_free( ptr );
+            return;
+        }
+#endif
+        ( void )isAligned;
+        std::free( ptr );
+    }
+}
+
+namespace Network
+{
+    uint64_t AllocationCounter::GetThreadCount()
+    {
+        return allocationsCount;
+    }
+}
+
+//! the array and nothrow forms of the standard library forward to these
+void * operator new( std::size_t size )
+{
+    return Allocate( size, 0u );
+}
+
+void * operator new( std::size_t size, std::align_val_t alignment )
+{
+    return Allocate( size, static_cast< std::size_t >( alignment ) );
+}
+
+void operator delete( void * ptr ) noexcept
+{
+    Free( ptr, false );
+}
+
+void operator delete( void * ptr, std::size_t ) noexcept
+{
+    Free( ptr, false );
+}
+
+void operator delete( void * ptr, std::align_val_t ) noexcept
+{
+    Free( ptr, true );
+}
+
+void operator delete( void * ptr, std::size_t, std::align_val_t ) noexcept
+{
+    Free( ptr, true );
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Network
+{
+    //! Counts the global operator new calls of every thread, so hot paths can be checked for allocations.
+    //! The count is kept per thread and costs one increment per allocation
+    class AllocationCounter
+    {
+    public:
+        static uint64_t GetThreadCount();
+    };
+}
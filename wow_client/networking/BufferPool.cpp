@@ -0,0 +1,64 @@
+#include "networking/BufferPool.hpp"
+
+#include <algorithm>
+
+namespace Network
+{
+    BufferPool & BufferPool::GetThreadPool()
+    {
+        thread_local BufferPool pool;
+        return pool;
+    }
+
+    ByteBuffer BufferPool::Acquire( size_t size )
+    {
+        ByteBuffer buffer;
+
+        const auto sizeClass = std::lower_bound( SIZE_CLASSES.begin(), SIZE_CLASSES.end(), size );
+        if ( sizeClass != SIZE_CLASSES.end() )
+        {
+            auto & freeList = m_free[ sizeClass - SIZE_CLASSES.begin() ];
+            if ( !freeList.empty() )
+            {
+                buffer.m_data = std::move( freeList.back() );
+                freeList.pop_back();
+            }
+            else
+            {
+                buffer.m_data.reserve( *sizeClass );
+            }
+        }
+
+        buffer.m_data.resize( size );
+        return buffer;
+    }
+
+    void BufferPool::Release( ByteBuffer & buffer )
+    {
+        auto storage = std::move( buffer.m_data );
+        buffer.m_data.clear();
+        buffer.m_readOffset = 0u;
+
+        //! storage goes to the largest class it can serve, oversized storage is dropped,
+        //! otherwise a single huge packet would pin its memory forever
+        const auto sizeClass = std::upper_bound( SIZE_CLASSES.begin(), SIZE_CLASSES.end(), storage.capacity() );
+        if ( sizeClass == SIZE_CLASSES.begin() || storage.capacity() > MAX_RETAINED_CAPACITY )
+            return;
+
+        auto & freeList = m_free[ sizeClass - SIZE_CLASSES.begin() - 1 ];
+        if ( freeList.size() >= MAX_FREE_BUFFERS )
+            return;
+
+        storage.clear();
+        freeList.push_back( std::move( storage ) );
+    }
+
+    size_t BufferPool::GetFreeCount() const
+    {
+        size_t count = 0u;
+        for ( auto & freeList : m_free )
+            count += freeList.size();
+
+        return count;
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "networking/ByteBuffer.hpp"
+
+#include <array>
+#include <utility>
+#include <vector>
+
+namespace Network
+{
+    //! Recycles packet storage. Every thread owns its own pool, with one thread per fleet shard
+    //! buffers are recycled per shard without any locking.
+    //! Storage is kept in size classes, so a small packet never takes a large buffer away from a large one.
+    class BufferPool
+    {
+    public:
+        static constexpr std::array< size_t, 6 > SIZE_CLASSES = { 128, 512, 2 * 1024, 8 * 1024, 32 * 1024, 64 * 1024 };
+        static constexpr size_t MAX_FREE_BUFFERS = 64;
+        static constexpr size_t MAX_RETAINED_CAPACITY = SIZE_CLASSES.back();
+
+        static BufferPool &     GetThreadPool();
+
+        //! Returns a buffer of exactly `size` bytes, its capacity is rounded up to the size class.
+        //! The bytes are left uninitialized, the caller overwrites all of them
+        ByteBuffer              Acquire( size_t size );
+
+        //! Takes the storage back, the buffer is left empty
+        void                    Release( ByteBuffer & buffer );
+
+        size_t                  GetFreeCount() const;
+
+    private:
+        using Storage = ByteStorage;
+
+        std::array< std::vector< Storage >, SIZE_CLASSES.size() > m_free;
+    };
+
+    //! Owns a buffer from the pool and hands its storage back to the pool of the destroying thread
+    class PooledBuffer
+    {
+    public:
+        PooledBuffer() = default;
+
+        explicit PooledBuffer( ByteBuffer buffer )
+            : m_buffer( std::move( buffer ) )
+        {
+        }
+
+        PooledBuffer( PooledBuffer && other ) noexcept
+            : m_buffer( std::exchange( other.m_buffer, {} ) )
+        {
+        }
+
+        PooledBuffer & operator=( PooledBuffer && other ) noexcept
+        {
+            if ( this != &other )
+            {
+                Reset();
+                m_buffer = std::exchange( other.m_buffer, {} );
+            }
+
+            return *this;
+        }
+
+        PooledBuffer( const PooledBuffer & ) = delete;
+        PooledBuffer & operator=( const PooledBuffer & ) = delete;
+
+        ~PooledBuffer()
+        {
+            Reset();
+        }
+
+        ByteBuffer & operator*() { return m_buffer; }
+        ByteBuffer * operator->() { return &m_buffer; }
+
+        //! Gives up ownership, e.g. to queue the buffer for sending
+        ByteBuffer Detach()
+        {
+            return std::exchange( m_buffer, {} );
+        }
+
+        void Reset()
+        {
+            if ( m_buffer.m_data.capacity() != 0u )
+                BufferPool::GetThreadPool().Release( m_buffer );
+        }
+
+    private:
+        ByteBuffer  m_buffer;
+    };
+}
@@ -1,48 +1,58 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <string_view>
 #include <gsl/span>
 
 namespace Network
 {
-    struct NullStringView : public std::string_view
+    //! Value-initializes nothing on resize: packet storage is always written right after it grows,
+    //! so zero filling it first, e.g. a recycled 64K buffer for every large packet, is wasted work
+    template< typename T >
+    struct DefaultInitAllocator : public std::allocator< T >
     {
-        NullStringView( std::string_view str = {} )
-            : std::string_view( str )
+        template< typename U >
+        struct rebind
+        {
+            using other = DefaultInitAllocator< U >;
+        };
+
+        using std::allocator< T >::allocator;
+
+        template< typename U >
+        void construct( U * ptr ) noexcept( std::is_nothrow_default_constructible_v< U > )
         {
+            ::new( static_cast< void * >( ptr ) ) U;
         }
-    };
 
-    template< typename Type = uint8_t >
-    struct BaseSizeStringView : public std::string_view
-    {
-        BaseSizeStringView( std::string_view str = {} )
-            : std::string_view( str )
+        template< typename U, typename ...Args >
+        void construct( U * ptr, Args && ... args )
         {
+            std::construct_at( ptr, std::forward< Args >( args )... );
         }
     };
 
-    using SizeStringView = BaseSizeStringView< uint8_t >;
+    using ByteStorage = std::vector< std::byte, DefaultInitAllocator< std::byte > >;
 
-    struct NullString : public std::string
+    struct NullStringView : public std::string_view
     {
-        NullString( std::string_view str = {} )
-            : std::string( str )
+        NullStringView( std::string_view str = {} )
+            : std::string_view( str )
         {
         }
     };
 
     template< typename Type = uint8_t >
-    struct BaseSizeString : public std::string
+    struct BaseSizeStringView : public std::string_view
     {
-        BaseSizeString( std::string_view str = {} )
-            : std::string( str )
+        BaseSizeStringView( std::string_view str = {} )
+            : std::string_view( str )
         {
         }
     };
 
-    using SizeString = BaseSizeString< uint8_t >;
+    using SizeStringView = BaseSizeStringView< uint8_t >;
 
     struct ByteBuffer
     {
@@ -81,59 +91,7 @@ namespace Network
             return *this;
         }
 
-        template< typename T >
-        T * Convert()
-        {
-            static_assert( std::is_pod_v< T > && !std::is_pointer_v<T>, "ERROR: only POD data supported!" );
-
-            if ( sizeof( T ) != m_data.size() )
-                std::terminate();
-
-            return reinterpret_cast< T * >( m_data.data() );
-        }
-
         size_t                   m_readOffset = 0u;
-        std::vector< std::byte > m_data;
+        ByteStorage              m_data;
     };
 }
-
-template< typename T >
-inline Network::ByteBuffer & operator<<( T & dst, Network::ByteBuffer & buffer )
-{
-    static_assert( std::is_pod_v< T > && !std::is_pointer_v<T>, "ERROR: only POD data supported!" );
-
-    if ( ( sizeof( T ) + buffer.m_readOffset ) > buffer.m_data.size() )
-        std::terminate();
-
-    std::memcpy( &dst, &( buffer.m_data[ buffer.m_readOffset ] ), sizeof( T ) );
-    buffer.m_readOffset += sizeof( T );
-    return buffer;
-}
-
-inline Network::ByteBuffer & operator<<( Network::NullString & dst, Network::ByteBuffer & buffer )
-{
-    auto begin = std::next( buffer.m_data.begin(), buffer.m_readOffset );
-    auto end = std::find( begin, buffer.m_data.end(), std::byte{} );
-
-    size_t size = std::distance( begin, end );
-
-    dst = std::string_view( reinterpret_cast< char * >( &( buffer.m_data[ buffer.m_readOffset ] ) ), size );
-    buffer.m_readOffset += size + 1;
-
-    return buffer;
-}
-
-template< typename U >
-inline Network::ByteBuffer & operator<<( Network::BaseSizeString< U > & dst, Network::ByteBuffer & buffer )
-{
-    U stringSize = {};
-    stringSize << buffer;
-
-    if ( ( stringSize + buffer.m_readOffset ) > buffer.m_data.size() )
-        std::terminate();
-
-    dst = std::string_view( ( char * )&buffer.m_data[ buffer.m_readOffset ], stringSize );
-    buffer.m_readOffset += stringSize;
-
-    return buffer;
-}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "networking/ByteBuffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <expected>
+#include <string_view>
+#include <type_traits>
+#include <gsl/span>
+
+namespace Network
+{
+    enum class ReadError : uint8_t
+    {
+        Truncated,
+        MissingTerminator
+    };
+
+    template< typename T >
+    using ReadResult = std::expected< T, ReadError >;
+
+    inline const char * ToString( ReadError error )
+    {
+        switch ( error )
+        {
+            case ReadError::Truncated:          return "truncated";
+            case ReadError::MissingTerminator:  return "missing string terminator";
+        }
+
+        return "unknown";
+    }
+
+    //! Non-owning read cursor over received bytes.
+    //! Nothing is copied to the heap, strings borrow from the viewed storage and must not outlive it.
+    //! A failed read reports why and leaves the cursor where it was.
+    class ByteBufferView
+    {
+    public:
+        ByteBufferView( gsl::span< const std::byte > data = {} )
+            : m_cursor( data.data() )
+            , m_end( data.data() + data.size() )
+        {
+        }
+
+        //! Starts at the buffer's read offset
+        ByteBufferView( const ByteBuffer & buffer )
+            : ByteBufferView( gsl::span< const std::byte >( buffer.m_data ).subspan( std::min( buffer.m_readOffset, buffer.m_data.size() ) ) )
+        {
+        }
+
+        size_t GetRemaining() const
+        {
+            return m_end - m_cursor;
+        }
+
+        const std::byte * GetCursor() const
+        {
+            return m_cursor;
+        }
+
+        template< typename T >
+        ReadResult< T > Read()
+        {
+            static_assert( std::is_trivially_copyable_v< T > && !std::is_pointer_v< T >, "ERROR: only POD data supported!" );
+
+            if ( GetRemaining() < sizeof( T ) )
+                return std::unexpected( ReadError::Truncated );
+
+            return ReadUnchecked< T >();
+        }
+
+        ReadResult< std::string_view > ReadNullString()
+        {
+            if ( m_cursor == m_end )
+                return std::unexpected( ReadError::MissingTerminator );
+
+            auto terminator = static_cast< const std::byte * >( std::memchr( m_cursor, 0, GetRemaining() ) );
+            if ( !terminator )
+                return std::unexpected( ReadError::MissingTerminator );
+
+            std::string_view str( reinterpret_cast< const char * >( m_cursor ), terminator - m_cursor );
+            m_cursor = terminator + 1;
+
+            return str;
+        }
+
+        template< typename SizeType = uint8_t >
+        ReadResult< std::string_view > ReadSizeString()
+        {
+            if ( GetRemaining() < sizeof( SizeType ) )
+                return std::unexpected( ReadError::Truncated );
+
+            SizeType size;
+            std::memcpy( &size, m_cursor, sizeof( SizeType ) );
+
+            if ( GetRemaining() - sizeof( SizeType ) < size )
+                return std::unexpected( ReadError::Truncated );
+
+            m_cursor += sizeof( SizeType );
+            return ReadStringUnchecked( size );
+        }
+
+        ReadResult< gsl::span< const std::byte > > ReadBytes( size_t size )
+        {
+            if ( GetRemaining() < size )
+                return std::unexpected( ReadError::Truncated );
+
+            gsl::span< const std::byte > bytes( m_cursor, size );
+            m_cursor += size;
+
+            return bytes;
+        }
+
+        ReadResult< void > Skip( size_t size )
+        {
+            if ( GetRemaining() < size )
+                return std::unexpected( ReadError::Truncated );
+
+            m_cursor += size;
+            return {};
+        }
+
+        //! For callers that already checked GetRemaining() for a whole run of fields
+        template< typename T >
+        T ReadUnchecked()
+        {
+            T value;
+            std::memcpy( &value, m_cursor, sizeof( T ) );
+            m_cursor += sizeof( T );
+
+            return value;
+        }
+
+        std::string_view ReadStringUnchecked( size_t size )
+        {
+            std::string_view str( reinterpret_cast< const char * >( m_cursor ), size );
+            m_cursor += size;
+
+            return str;
+        }
+
+        void SkipUnchecked( size_t size )
+        {
+            m_cursor += size;
+        }
+
+    private:
+        const std::byte *   m_cursor;
+        const std::byte *   m_end;
+    };
+}
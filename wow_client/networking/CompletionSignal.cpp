@@ -0,0 +1,60 @@
+#include "networking/CompletionSignal.hpp"
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+namespace Network
+{
+    boost::asio::awaitable<void> CompletionSignal::WaitAsync()
+    {
+        auto executor = co_await boost::asio::this_coro::executor;
+
+        std::shared_ptr< boost::asio::steady_timer > timer;
+        {
+            std::lock_guard lock( m_mutex );
+            if ( m_isSet )
+                co_return;
+
+            timer = std::make_shared< boost::asio::steady_timer >( executor, boost::asio::steady_timer::time_point::max() );
+            m_waiters.push_back( timer );
+        }
+
+        //! a waiter destroyed with its stopped executor leaves the list, Set must not post to an executor that is gone
+        struct Registration
+        {
+            ~Registration()
+            {
+                std::lock_guard lock( m_signal.m_mutex );
+                std::erase( m_signal.m_waiters, m_timer );
+            }
+
+            CompletionSignal &                              m_signal;
+            std::shared_ptr< boost::asio::steady_timer >    m_timer;
+        } registration{ *this, timer };
+
+        boost::system::error_code error;
+        co_await timer->async_wait( boost::asio::redirect_error( boost::asio::use_awaitable, error ) );
+    }
+
+    void CompletionSignal::Set()
+    {
+        std::vector< std::shared_ptr< boost::asio::steady_timer > > waiters;
+        {
+            std::lock_guard lock( m_mutex );
+
+            m_isSet = true;
+            waiters = std::move( m_waiters );
+        }
+
+        //! timers aren't thread safe, each one is cancelled on the executor of its waiter
+        for ( auto & timer : waiters )
+        {
+            boost::asio::post( timer->get_executor(), [timer]
+            {
+                timer->cancel();
+            } );
+        }
+    }
+}
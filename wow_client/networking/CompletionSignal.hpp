@@ -0,0 +1,24 @@
+#pragma once
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Network
+{
+    //! One shot event that coroutines on any executor can wait for, Set wakes every waiter on its own executor
+    class CompletionSignal
+    {
+    public:
+        boost::asio::awaitable<void>    WaitAsync();
+        void                            Set();
+
+    private:
+        std::mutex                                                  m_mutex;
+        bool                                                        m_isSet = false;
+        std::vector< std::shared_ptr< boost::asio::steady_timer > > m_waiters;
+    };
+}
@@ -0,0 +1,83 @@
+#include "networking/EndpointResolver.hpp"
+
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+namespace Network
+{
+    EndpointResolver::EndpointResolver( std::chrono::seconds ttl )
+        : m_ttl( ttl )
+    {
+    }
+
+    boost::asio::awaitable< ResolveResult > EndpointResolver::ResolveAsync( std::string_view address, uint16_t defaultPort )
+    {
+        std::string host( address );
+        std::string port = std::to_string( defaultPort );
+
+        const auto pos = address.find_last_of( ':' );
+        if ( pos != std::string_view::npos )
+        {
+            host = address.substr( 0, pos );
+            port = address.substr( pos + 1 );
+        }
+
+        std::string key = host + ":" + port;
+        auto executor = co_await boost::asio::this_coro::executor;
+
+        std::shared_ptr< PendingLookup > lookup;
+        bool isResolving = false;
+        {
+            std::lock_guard lock( m_mutex );
+
+            auto itr = m_cache.find( key );
+            if ( itr != m_cache.end() && itr->second.m_expiry > Clock::now() )
+                co_return itr->second.m_result;
+
+            //! the first caller resolves, everybody else waits for its result
+            auto & pending = m_pending[ key ];
+            isResolving = pending != nullptr;
+
+            if ( !pending )
+                pending = std::make_shared< PendingLookup >();
+
+            lookup = pending;
+        }
+
+        if ( isResolving )
+        {
+            co_await lookup->m_done.WaitAsync();
+
+            std::lock_guard lock( m_mutex );
+            co_return lookup->m_result;
+        }
+
+        ResolveResult result;
+
+        boost::asio::ip::tcp::resolver resolver( executor );
+        result.m_endpoints = co_await resolver.async_resolve( host, port, boost::asio::redirect_error( boost::asio::use_awaitable, result.m_error ) );
+
+        if ( !result.m_error && result.m_endpoints.empty() )
+            result.m_error = boost::asio::error::host_not_found;
+
+        Complete( key, lookup, result );
+        co_return result;
+    }
+
+    void EndpointResolver::Complete( const std::string & key, const std::shared_ptr< PendingLookup > & lookup, ResolveResult result )
+    {
+        {
+            std::lock_guard lock( m_mutex );
+
+            //! failures are kept only briefly so a flapping dns doesn't hold the fleet back for the whole ttl
+            const auto ttl = result.m_error ? std::chrono::duration_cast< std::chrono::seconds >( FAILURE_TTL ) : m_ttl;
+            m_cache[ key ] = { result, Clock::now() + ttl };
+
+            lookup->m_result = std::move( result );
+            m_pending.erase( key );
+        }
+
+        lookup->m_done.Set();
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "networking/CompletionSignal.hpp"
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Network
+{
+    struct ResolveResult
+    {
+        boost::system::error_code                           m_error;
+        boost::asio::ip::tcp::resolver::results_type        m_endpoints;
+    };
+
+    //! Shared by every shard: `host:port` lookups are cached for a while and concurrent lookups of the same
+    //! address are merged, the first caller resolves and everybody else waits on its own executor for the result
+    class EndpointResolver
+    {
+    public:
+        static constexpr auto DEFAULT_TTL = std::chrono::minutes( 5 );
+        static constexpr auto FAILURE_TTL = std::chrono::seconds( 5 );
+
+        EndpointResolver( std::chrono::seconds ttl = DEFAULT_TTL );
+
+        //! `address` is `host[:port]`, `defaultPort` is used when it has no port
+        boost::asio::awaitable< ResolveResult > ResolveAsync( std::string_view address, uint16_t defaultPort );
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct CacheEntry
+        {
+            ResolveResult       m_result;
+            Clock::time_point   m_expiry;
+        };
+
+        struct PendingLookup
+        {
+            ResolveResult       m_result;
+            CompletionSignal    m_done;
+        };
+
+        void                    Complete( const std::string & key, const std::shared_ptr< PendingLookup > & lookup, ResolveResult result );
+
+        std::chrono::seconds                                                m_ttl;
+        std::mutex                                                          m_mutex;
+        std::unordered_map< std::string, CacheEntry >                       m_cache;
+        std::unordered_map< std::string, std::shared_ptr< PendingLookup > > m_pending;
+    };
+}
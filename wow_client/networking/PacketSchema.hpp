@@ -0,0 +1,433 @@
+#pragma once
+
+#include "networking/BufferPool.hpp"
+#include "networking/ByteBuffer.hpp"
+#include "networking/ByteBufferView.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <gsl/span>
+#include <string_view>
+#include <type_traits>
+
+namespace Network
+{
+    //! Compile time packet layouts.
+    //! A packet is described once as a list of fields and both the parser and the serializer are generated from it.
+    //! Consecutive fixed size fields are fused into a run that is bounds checked once and then copied unchecked,
+    //! only variable sized fields ( strings, repeated and conditional blocks ) start a new run.
+    namespace Schema
+    {
+        constexpr size_t VARIABLE_SIZE = 0u;
+
+        //! Writes are never checked, the whole packet is sized up front
+        struct Writer
+        {
+            size_t GetRemaining() const
+            {
+                return m_end - m_cursor;
+            }
+
+            template< typename T >
+            void Put( const T & value )
+            {
+                std::memcpy( m_cursor, &value, sizeof( T ) );
+                m_cursor += sizeof( T );
+            }
+
+            void Put( std::string_view str )
+            {
+                std::memcpy( m_cursor, str.data(), str.size() );
+                m_cursor += str.size();
+            }
+
+            std::byte *         m_cursor;
+            std::byte *         m_end;
+        };
+
+        template< typename T >
+        struct MemberTraits;
+
+        template< typename Object, typename T >
+        struct MemberTraits< T Object::* >
+        {
+            using Type = T;
+        };
+
+        template< auto Member >
+        using MemberType = typename MemberTraits< decltype( Member ) >::Type;
+
+        //! Fixed size member copied as is
+        template< auto Member >
+        struct Field
+        {
+            static_assert( std::is_trivially_copyable_v< MemberType< Member > > && !std::is_pointer_v< MemberType< Member > > );
+
+            static constexpr size_t FIXED_SIZE = sizeof( MemberType< Member > );
+
+            template< typename Object >
+            static void ReadUnchecked( ByteBufferView & reader, Object & object )
+            {
+                object.*Member = reader.ReadUnchecked< MemberType< Member > >();
+            }
+
+            template< typename Object >
+            static void Write( Writer & writer, const Object & object )
+            {
+                writer.Put( object.*Member );
+            }
+        };
+
+        //! Fixed size value the object does not keep, skipped when reading
+        template< typename T, T Value = T{} >
+        struct Constant
+        {
+            static constexpr size_t FIXED_SIZE = sizeof( T );
+
+            template< typename Object >
+            static void ReadUnchecked( ByteBufferView & reader, Object & )
+            {
+                reader.SkipUnchecked( FIXED_SIZE );
+            }
+
+            template< typename Object >
+            static void Write( Writer & writer, const Object & )
+            {
+                writer.Put( Value );
+            }
+        };
+
+        //! Zeroed bytes the object does not keep, skipped when reading
+        template< size_t N >
+        struct Padding
+        {
+            static constexpr size_t FIXED_SIZE = N;
+
+            template< typename Object >
+            static void ReadUnchecked( ByteBufferView & reader, Object & )
+            {
+                reader.SkipUnchecked( FIXED_SIZE );
+            }
+
+            template< typename Object >
+            static void Write( Writer & writer, const Object & )
+            {
+                std::memset( writer.m_cursor, 0, FIXED_SIZE );
+                writer.m_cursor += FIXED_SIZE;
+            }
+        };
+
+        //! Size of everything that follows it in the packet, skipped when reading
+        template< typename T >
+        struct RemainingSize
+        {
+            static constexpr size_t FIXED_SIZE = sizeof( T );
+
+            template< typename Object >
+            static void ReadUnchecked( ByteBufferView & reader, Object & )
+            {
+                reader.SkipUnchecked( FIXED_SIZE );
+            }
+
+            template< typename Object >
+            static void Write( Writer & writer, const Object & )
+            {
+                writer.Put( static_cast< T >( writer.GetRemaining() - FIXED_SIZE ) );
+            }
+        };
+
+        template< auto Member >
+        struct NullTerminated
+        {
+            static constexpr size_t FIXED_SIZE = VARIABLE_SIZE;
+
+            template< typename Object >
+            static ReadResult< void > Read( ByteBufferView & reader, Object & object )
+            {
+                const auto str = reader.ReadNullString();
+                if ( !str )
+                    return std::unexpected( str.error() );
+
+                object.*Member = *str;
+                return {};
+            }
+
+            template< typename Object >
+            static size_t SizeOf( const Object & object )
+            {
+                return std::string_view( object.*Member ).size() + 1;
+            }
+
+            template< typename Object >
+            static void Write( Writer & writer, const Object & object )
+            {
+                writer.Put( std::string_view( object.*Member ) );
+                writer.Put( uint8_t{ 0 } );
+            }
+        };
+
+        template< auto Member, typename SizeType = uint8_t >
+        struct LengthPrefixed
+        {
+            static constexpr size_t FIXED_SIZE = VARIABLE_SIZE;
+
+            template< typename Object >
+            static ReadResult< void > Read( ByteBufferView & reader, Object & object )
+            {
+                const auto str = reader.ReadSizeString< SizeType >();
+                if ( !str )
+                    return std::unexpected( str.error() );
+
+                object.*Member = *str;
+                return {};
+            }
+
+            template< typename Object >
+            static size_t SizeOf( const Object & object )
+            {
+                return sizeof( SizeType ) + std::string_view( object.*Member ).size();
+            }
+
+            template< typename Object >
+            static void Write( Writer & writer, const Object & object )
+            {
+                const std::string_view str = object.*Member;
+
+                writer.Put( static_cast< SizeType >( str.size() ) );
+                writer.Put( str );
+            }
+        };
+
+        //! Count prefixed sequence of elements, each laid out by the element schema
+        template< auto Member, typename CountType, typename ElementSchema >
+        struct Repeated
+        {
+            static constexpr size_t FIXED_SIZE = VARIABLE_SIZE;
+
+            template< typename Object >
+            static ReadResult< void > Read( ByteBufferView & reader, Object & object )
+            {
+                const auto count = reader.Read< CountType >();
+                if ( !count )
+                    return std::unexpected( count.error() );
+
+                auto & elements = object.*Member;
+                elements.clear();
+
+                //! every element takes at least a byte, a bogus count can't reserve more than the packet holds
+                elements.reserve( std::min< size_t >( *count, reader.GetRemaining() ) );
+
+                for ( size_t idx = 0u; idx < *count; ++idx )
+                {
+                    if ( auto result = ElementSchema::Read( reader, elements.emplace_back() ); !result )
+                        return result;
+                }
+
+                return {};
+            }
+
+            template< typename Object >
+            static size_t SizeOf( const Object & object )
+            {
+                size_t size = sizeof( CountType );
+                for ( auto & element : object.*Member )
+                    size += ElementSchema::SizeOf( element );
+
+                return size;
+            }
+
+            template< typename Object >
+            static void Write( Writer & writer, const Object & object )
+            {
+                writer.Put( static_cast< CountType >( ( object.*Member ).size() ) );
+
+                for ( auto & element : object.*Member )
+                    ElementSchema::Write( writer, element );
+            }
+        };
+
+        //! Condition for When, true if the flag is set in a member that precedes the block
+        template< auto Member, auto Flag >
+        struct FlagSet
+        {
+            template< typename Object >
+            static bool Test( const Object & object )
+            {
+                using Underlying = std::underlying_type_t< decltype( Flag ) >;
+                return ( static_cast< Underlying >( object.*Member ) & static_cast< Underlying >( Flag ) ) != 0;
+            }
+        };
+
+        template< typename ...Fields >
+        struct FieldList;
+
+        //! Fields that are only present when the condition holds
+        template< typename Condition, typename ...Fields >
+        struct When
+        {
+            static constexpr size_t FIXED_SIZE = VARIABLE_SIZE;
+
+            template< typename Object >
+            static ReadResult< void > Read( ByteBufferView & reader, Object & object )
+            {
+                if ( !Condition::Test( object ) )
+                    return {};
+
+                return FieldList< Fields... >::Read( reader, object );
+            }
+
+            template< typename Object >
+            static size_t SizeOf( const Object & object )
+            {
+                return Condition::Test( object ) ? FieldList< Fields... >::SizeOf( object ) : 0u;
+            }
+
+            template< typename Object >
+            static void Write( Writer & writer, const Object & object )
+            {
+                if ( Condition::Test( object ) )
+                    FieldList< Fields... >::Write( writer, object );
+            }
+        };
+
+        template< typename ...Fields >
+        constexpr size_t FIXED_RUN_SIZE = 0u;
+
+        //! Size of the leading fixed size fields, this is what a single bounds check covers
+        template< typename First, typename ...Rest >
+        constexpr size_t FIXED_RUN_SIZE< First, Rest... > = First::FIXED_SIZE == VARIABLE_SIZE ? 0u : First::FIXED_SIZE + FIXED_RUN_SIZE< Rest... >;
+
+        template< typename ...Fields >
+        struct FieldList
+        {
+            //! Known at compile time when there is no variable sized field
+            static constexpr size_t FIXED_SIZE = ( ( Fields::FIXED_SIZE != VARIABLE_SIZE ) && ... ) ? ( size_t{ 0u } + ... + Fields::FIXED_SIZE ) : VARIABLE_SIZE;
+
+            template< typename Object >
+            static ReadResult< void > Read( ByteBufferView & reader, Object & object )
+            {
+                return ReadFields< 0u, Object, Fields... >( reader, object );
+            }
+
+            template< typename Object >
+            static size_t SizeOf( const Object & object )
+            {
+                if constexpr ( FIXED_SIZE != VARIABLE_SIZE )
+                    return FIXED_SIZE;
+                else
+                    return ( size_t{ 0u } + ... + SizeOfField< Fields >( object ) );
+            }
+
+            template< typename Object >
+            static void Write( Writer & writer, const Object & object )
+            {
+                ( Fields::Write( writer, object ), ... );
+            }
+
+        private:
+            //! `Checked` is how many bytes of the current run were already bounds checked
+            template< size_t Checked, typename Object >
+            static ReadResult< void > ReadFields( ByteBufferView &, Object & )
+            {
+                return {};
+            }
+
+            template< size_t Checked, typename Object, typename First, typename ...Rest >
+            static ReadResult< void > ReadFields( ByteBufferView & reader, Object & object )
+            {
+                if constexpr ( First::FIXED_SIZE == VARIABLE_SIZE )
+                {
+                    if ( auto result = First::Read( reader, object ); !result )
+                        return result;
+
+                    return ReadFields< 0u, Object, Rest... >( reader, object );
+                }
+                else if constexpr ( Checked >= First::FIXED_SIZE )
+                {
+                    First::ReadUnchecked( reader, object );
+                    return ReadFields< Checked - First::FIXED_SIZE, Object, Rest... >( reader, object );
+                }
+                else
+                {
+                    constexpr size_t runSize = FIXED_RUN_SIZE< First, Rest... >;
+                    if ( reader.GetRemaining() < runSize )
+                        return std::unexpected( ReadError::Truncated );
+
+                    First::ReadUnchecked( reader, object );
+                    return ReadFields< runSize - First::FIXED_SIZE, Object, Rest... >( reader, object );
+                }
+            }
+
+            template< typename Field, typename Object >
+            static size_t SizeOfField( const Object & object )
+            {
+                if constexpr ( Field::FIXED_SIZE == VARIABLE_SIZE )
+                    return Field::SizeOf( object );
+                else
+                    return Field::FIXED_SIZE;
+            }
+        };
+    }
+
+    //! Layout of a whole packet, usable on its own or as the element schema of a repeated block
+    template< typename Object, typename ...Fields >
+    struct PacketSchema
+    {
+        using Type = Object;
+
+        static constexpr size_t FIXED_SIZE = Schema::FieldList< Fields... >::FIXED_SIZE;
+
+        //! Strings borrow from the viewed storage, the object must not outlive it
+        static ReadResult< void > Read( ByteBufferView & reader, Object & object )
+        {
+            return Schema::FieldList< Fields... >::Read( reader, object );
+        }
+
+        static size_t SizeOf( const Object & object )
+        {
+            return Schema::FieldList< Fields... >::SizeOf( object );
+        }
+
+        static void Write( Schema::Writer & writer, const Object & object )
+        {
+            Schema::FieldList< Fields... >::Write( writer, object );
+        }
+
+        //! Appends the packet with a single resize
+        static void Write( ByteBuffer & buffer, const Object & object )
+        {
+            const size_t index = buffer.m_data.size();
+            const size_t size = SizeOf( object );
+            buffer.m_data.resize( index + size );
+
+            Schema::Writer writer{ buffer.m_data.data() + index, buffer.m_data.data() + index + size };
+            Write( writer, object );
+        }
+
+        //! Writes into the caller's storage, nothing is written when the packet doesn't fit
+        static bool Write( gsl::span< std::byte > storage, const Object & object )
+        {
+            const size_t size = SizeOf( object );
+            if ( size > storage.size() )
+                return false;
+
+            Schema::Writer writer{ storage.data(), storage.data() + size };
+            Write( writer, object );
+
+            return true;
+        }
+
+        //! Packet in a buffer from the thread pool, sized exactly in one allocation.
+        //! The first `headroom` bytes are left for a header the caller fills in place once the payload is written.
+        static ByteBuffer Build( const Object & object, size_t headroom = 0u )
+        {
+            const size_t size = SizeOf( object );
+            ByteBuffer buffer = BufferPool::GetThreadPool().Acquire( headroom + size );
+
+            Schema::Writer writer{ buffer.m_data.data() + headroom, buffer.m_data.data() + headroom + size };
+            Write( writer, object );
+
+            return buffer;
+        }
+    };
+}
@@ -1,28 +1,67 @@
 #pragma once
 
+#include "networking/BufferPool.hpp"
 #include "networking/ByteBuffer.hpp"
+#include "networking/EndpointResolver.hpp"
+
+#if defined( HEADLESSY_ALLOCATION_STATS )
+    #include "networking/AllocationCounter.hpp"
+#endif
 
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/awaitable.hpp>
-#include <boost/thread/concurrent_queues/sync_deque.hpp>
 #include <boost/asio/use_awaitable.hpp>
 #include <boost/asio/detached.hpp>
 #include <boost/asio/read.hpp>
 #include <boost/asio/write.hpp>
 #include <boost/asio/co_spawn.hpp>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/post.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <gsl/span>
+#include <vector>
 
 namespace Network
 {
-    template< typename PacketHeader, size_t BUFFER_SIZE = 2048 >
+    //! What SendBuffer does with a buffer that would take the outgoing queue above the high-water mark
+    enum class HighWaterPolicy : uint8_t
+    {
+        Reject,         //! the buffer is not queued and SendBuffer returns false, the connection stays up
+        Disconnect      //! the connection is closed as a slow consumer, for streams that can't skip a packet
+    };
+
+    template< typename PacketHeader, size_t BUFFER_SIZE = 16384 >
     class Socket
     {
     public:
         using Endpoint = boost::asio::ip::tcp::endpoint;
+        using NotifyHandler = std::function< void() >;
+
+        static constexpr size_t DEFAULT_HIGH_WATER_MARK = 256 * 1024;
 
         Socket( boost::asio::io_context & context )
             : m_buffer{}
+            , m_readOffset( 0u )
+            , m_writeOffset( 0u )
+            , m_outgoingSize( 0u )
+            , m_writing( false )
+            , m_connected( false )
+            , m_connecting( false )
+            , m_highWaterMark( DEFAULT_HIGH_WATER_MARK )
+            , m_highWaterPolicy( HighWaterPolicy::Reject )
             , m_context( context )
             , m_socket( context )
+            , m_lifetime( std::make_shared< bool >() )
         {
         }
 
@@ -37,20 +76,56 @@ namespace Network
             return m_socket.is_open();
         }
 
-        boost::system::error_code Connect( Endpoint endpoint )
+        bool IsConnecting() const
         {
-            boost::system::error_code error;
-            m_socket.connect( endpoint, error );
+            return m_connecting;
+        }
 
-            if ( error )
-                return error;
+        //! Handler is invoked on the socket thread whenever the session has new work for its owner:
+        //! a packet was queued or the connection was lost
+        void SetNotifyHandler( NotifyHandler handler )
+        {
+            m_notifyHandler = std::move( handler );
+        }
+
+        //! Resolves and connects without blocking the thread, OnConnected runs once the connection is up.
+        //! A failed attempt leaves the socket closed and notifies the owner.
+        void ConnectAsync( EndpointResolver & resolver, std::string address, uint16_t defaultPort )
+        {
+            m_connecting = true;
 
-            boost::asio::co_spawn( m_context, [this]
+            boost::asio::co_spawn( m_context, [this, &resolver, address = std::move( address ), defaultPort, lifetime = GetLifetimeToken()]() -> boost::asio::awaitable<void>
             {
-                return SocketReaderAsync();
-            }, boost::asio::detached );
+                auto [error, endpoints] = co_await resolver.ResolveAsync( address, defaultPort );
+                if ( lifetime.expired() )
+                    co_return;
+
+                if ( !error )
+                    co_await boost::asio::async_connect( m_socket, endpoints, boost::asio::redirect_error( boost::asio::use_awaitable, error ) );
+
+                if ( lifetime.expired() )
+                    co_return;
+
+                m_connecting = false;
+
+                if ( error )
+                {
+                    std::cerr << "[ERROR] Could not connect to " << address << ": " << error.message() << "\n";
+                    Notify();
+                    co_return;
+                }
 
-            return error;
+                m_readOffset = 0u;
+                m_writeOffset = 0u;
+                m_connected = true;
+
+                boost::asio::co_spawn( m_context, [this, lifetime]
+                {
+                    return SocketReaderAsync( lifetime );
+                }, boost::asio::detached );
+
+                OnConnected();
+            }, boost::asio::detached );
         }
 
         uint32_t GetLocalAddress() const
@@ -69,29 +144,147 @@ namespace Network
             return m_socket.remote_endpoint().address().to_v4().to_uint();
         }
 
-        void SendBuffer( ByteBuffer & buffer )
+        //! Maximum amount of queued outgoing bytes, what happens above it is up to the HighWaterPolicy of the session
+        void SetHighWaterMark( size_t bytes )
         {
-            //! TODO: make it async
-            boost::system::error_code error;
-            boost::asio::write( m_socket, boost::asio::buffer( buffer.m_data.data(), buffer.m_data.size() ), error );
+            m_highWaterMark = bytes;
+        }
+
+        size_t GetOutgoingSize() const
+        {
+            return m_outgoingSize;
+        }
+
+#if defined( HEADLESSY_ALLOCATION_STATS )
+        //! Packets received without waiting on the socket or the consumer, and the heap allocations they took
+        //! from reading the header to ReceivePacketAsync returning. Only valid on the socket thread
+        size_t GetBufferedPacketsCount() const
+        {
+            return m_bufferedPacketsCount;
+        }
+
+        uint64_t GetBufferedPacketAllocations() const
+        {
+            return m_bufferedPacketAllocations;
+        }
+#endif
+
+        //! Queues the buffer without blocking, everything queued while a write is in flight goes out in a single gathered write.
+        //! Returns false when the connection is gone or the queue is above the high-water mark, see HighWaterPolicy.
+        //! Sockets live on a single shard thread, the queue is only touched from there.
+        [[nodiscard]] bool SendBuffer( ByteBuffer buffer )
+        {
+            const size_t size = buffer.m_data.size();
+            if ( !m_connected )
+                return false;
+
+            if ( m_outgoingSize != 0u && m_outgoingSize + size > m_highWaterMark )
+            {
+                if ( m_highWaterPolicy == HighWaterPolicy::Disconnect )
+                {
+                    std::cerr << "[ERROR] " << m_outgoingSize << " bytes still queued, closing the connection as a slow consumer\n";
+                    Disconnect();
+                }
+
+                return false;
+            }
 
-            if ( error )
-                std::terminate();
+            m_outgoingSize += size;
+            m_outgoing.push_back( std::move( buffer ) );
+
+            if ( !m_writing )
+            {
+                m_writing = true;
+
+                boost::asio::co_spawn( m_context, [this, lifetime = GetLifetimeToken()]
+                {
+                    return SocketWriterAsync( lifetime );
+                }, boost::asio::detached );
+            }
+
+            return true;
         }
 
     protected:
         virtual boost::asio::awaitable<bool> ReceivePacketAsync( PacketHeader header ) = 0;
 
+        virtual void OnConnected()
+        {
+        }
+
+        void SetHighWaterPolicy( HighWaterPolicy policy )
+        {
+            m_highWaterPolicy = policy;
+        }
+
+        //! Expires with the socket, coroutines that wait on something other than the socket check it before touching `this`
+        std::weak_ptr< void > GetLifetimeToken() const
+        {
+            return m_lifetime;
+        }
+
+        auto GetExecutor()
+        {
+            return m_socket.get_executor();
+        }
+
+        //! Closes the connection and notifies the owner, a pending read ends without touching the socket again
+        void Disconnect()
+        {
+            m_connected = false;
+
+            boost::system::error_code error;
+            m_socket.close( error );
+
+            Notify();
+        }
+
+        void Notify()
+        {
+            if ( m_notifyHandler )
+                m_notifyHandler();
+        }
+
+        //! Called by the reader when the owner's packet queue is full, wakes the owner and lets it drain the queue.
+        //! The owner may destroy the session while draining, the reader then ends through the aborted read path.
+        boost::asio::awaitable<void> WaitForConsumerAsync()
+        {
+            auto lifetime = GetLifetimeToken();
+
+            Notify();
+
+            MarkReadSuspended();
+            co_await boost::asio::post( m_socket.get_executor(), boost::asio::use_awaitable );
+
+            ThrowIfExpired( lifetime );
+        }
+
+        //! Synchronous counterpart of ReadAsync( span ), succeeds only when everything is already buffered.
+        //! Every ReadAsync call costs a coroutine frame, hot paths try this first and only await when it fails.
+        bool TryRead( gsl::span< std::byte > destination )
+        {
+            if ( GetBufferedSize() < destination.size() )
+                return false;
+
+            std::memcpy( destination.data(), m_buffer.data() + m_readOffset, destination.size() );
+            m_readOffset += destination.size();
+
+            return true;
+        }
+
+        //! All reads are served from the receive buffer, the socket is only touched when the buffer runs dry
+        //! and then it reads as much as is available, so a burst of packets costs a single recv
         template< typename ...T >
         auto ReadAsync() -> std::enable_if_t< sizeof...( T ) >= 2u, boost::asio::awaitable< std::tuple<T...> > >
         {
-            static_assert( sizeof( std::tuple<T...> ) <= BUFFER_SIZE );
+            constexpr size_t size = ( sizeof( T ) + ... );
+            static_assert( size <= BUFFER_SIZE );
 
-            const size_t bytesReceived = co_await boost::asio::async_read( m_socket, boost::asio::buffer( m_buffer.data(), sizeof( std::tuple<T...> ) ), boost::asio::use_awaitable );
-            if ( bytesReceived != sizeof( std::tuple<T...> ) )
-                std::terminate();
+            if ( GetBufferedSize() < size )
+                co_await FillAsync( size );
 
-            co_return *reinterpret_cast< std::tuple<T... > * >( m_buffer.data() );
+            //! braced initialization guarantees left to right evaluation
+            co_return std::tuple<T...>{ Consume<T>()... };
         }
 
         template< typename T >
@@ -100,43 +293,237 @@ namespace Network
             static_assert( std::is_pod_v<T> );
             static_assert( sizeof( T ) <= BUFFER_SIZE );
 
-            const size_t bytesReceived = co_await boost::asio::async_read( m_socket, boost::asio::buffer( m_buffer.data(), sizeof( T ) ), boost::asio::use_awaitable );
-            if ( bytesReceived != sizeof( T ) )
-                std::terminate();
+            if ( GetBufferedSize() < sizeof( T ) )
+                co_await FillAsync( sizeof( T ) );
 
-            co_return *reinterpret_cast< T * >( m_buffer.data() );
+            co_return Consume<T>();
         }
 
-        auto ReadAsync( size_t bytesCount ) -> boost::asio::awaitable< ByteBuffer >
+        auto ReadAsync( gsl::span< std::byte > destination ) -> boost::asio::awaitable< void >
         {
-            const size_t bytesReceived = co_await boost::asio::async_read( m_socket, boost::asio::buffer( m_buffer.data(), bytesCount ), boost::asio::use_awaitable );
-            if ( bytesReceived != bytesCount )
-                std::terminate();
+            const size_t buffered = std::min( GetBufferedSize(), destination.size() );
+            std::memcpy( destination.data(), m_buffer.data() + m_readOffset, buffered );
+            m_readOffset += buffered;
+
+            const size_t remaining = destination.size() - buffered;
+            if ( remaining == 0u )
+                co_return;
+
+            //! large payloads go straight into the destination instead of bouncing through the receive buffer
+            if ( remaining > BUFFER_SIZE )
+            {
+                auto lifetime = GetLifetimeToken();
 
-            ByteBuffer buffer;
-            buffer.m_data.resize( bytesCount );
+                MarkReadSuspended();
+                co_await boost::asio::async_read( m_socket, boost::asio::buffer( destination.data() + buffered, remaining ), boost::asio::use_awaitable );
 
-            std::memcpy( buffer.m_data.data(), m_buffer.data(), bytesCount );
+                ThrowIfExpired( lifetime );
+                co_return;
+            }
+
+            co_await FillAsync( remaining );
+
+            std::memcpy( destination.data() + buffered, m_buffer.data() + m_readOffset, remaining );
+            m_readOffset += remaining;
+        }
+
+        //! Payload lands in a buffer taken from the thread pool, it goes back once the consumer drops the handle
+        auto ReadAsync( size_t bytesCount ) -> boost::asio::awaitable< PooledBuffer >
+        {
+            PooledBuffer buffer( BufferPool::GetThreadPool().Acquire( bytesCount ) );
+
+            co_await ReadAsync( gsl::span< std::byte >( buffer->m_data ) );
             co_return buffer;
         }
 
     private:
-        boost::asio::awaitable<void> SocketReaderAsync()
+        //! A read that completed right before the owner destroyed the session still resumes its coroutine successfully,
+        //! this ends the whole read chain through the aborted read path without touching the session again
+        static void ThrowIfExpired( const std::weak_ptr< void > & lifetime )
+        {
+            if ( lifetime.expired() )
+                throw boost::system::system_error( boost::asio::error::operation_aborted );
+        }
+
+        size_t GetBufferedSize() const
+        {
+            return m_writeOffset - m_readOffset;
+        }
+
+        //! The read is about to wait on the socket or the consumer, the current packet doesn't count as buffered
+        void MarkReadSuspended()
+        {
+#if defined( HEADLESSY_ALLOCATION_STATS )
+            m_readSuspended = true;
+#endif
+        }
+
+        template< typename T >
+        T Consume()
         {
-            while ( m_socket.is_open() )
+            T value;
+            std::memcpy( &value, m_buffer.data() + m_readOffset, sizeof( T ) );
+            m_readOffset += sizeof( T );
+
+            return value;
+        }
+
+        //! Waits until at least `bytesCount` bytes are buffered
+        boost::asio::awaitable<void> FillAsync( size_t bytesCount )
+        {
+            //! nothing left to keep, start over so the read gets the whole buffer instead of whatever is left at its end
+            if ( GetBufferedSize() == 0u )
             {
-                auto header = co_await ReadAsync<PacketHeader>();
+                m_readOffset = 0u;
+                m_writeOffset = 0u;
+            }
+            else if ( m_readOffset + bytesCount > BUFFER_SIZE )
+            {
+                //! move the partial packet to the front to make room for the rest of it
+                std::memmove( m_buffer.data(), m_buffer.data() + m_readOffset, GetBufferedSize() );
+                m_writeOffset -= m_readOffset;
+                m_readOffset = 0u;
+            }
 
-                const bool handled = co_await ReceivePacketAsync( std::move( header ) );
-                if ( !handled )
-                    std::terminate();
+            auto lifetime = GetLifetimeToken();
+            while ( GetBufferedSize() < bytesCount )
+            {
+                auto freeSpace = boost::asio::buffer( m_buffer.data() + m_writeOffset, BUFFER_SIZE - m_writeOffset );
+
+                MarkReadSuspended();
+                const size_t bytesRead = co_await m_socket.async_read_some( freeSpace, boost::asio::use_awaitable );
+
+                ThrowIfExpired( lifetime );
+                m_writeOffset += bytesRead;
             }
         }
 
+        //! Spawning only posts the first step, the owner may already be gone when it runs
+        boost::asio::awaitable<void> SocketReaderAsync( std::weak_ptr< void > lifetime )
+        {
+            if ( lifetime.expired() )
+                co_return;
+
+            try
+            {
+                while ( m_socket.is_open() )
+                {
+                    //! taken straight from the receive buffer, so a packet costs no coroutine frame beyond ReceivePacketAsync
+                    if ( GetBufferedSize() < sizeof( PacketHeader ) )
+                        co_await FillAsync( sizeof( PacketHeader ) );
+
+#if defined( HEADLESSY_ALLOCATION_STATS )
+                    m_readSuspended = false;
+                    const uint64_t allocations = AllocationCounter::GetThreadCount();
+#endif
+
+                    //! a packet the session can't frame leaves the stream out of sync, drop just this connection
+                    const bool handled = co_await ReceivePacketAsync( Consume< PacketHeader >() );
+                    if ( lifetime.expired() )
+                        co_return;
+
+#if defined( HEADLESSY_ALLOCATION_STATS )
+                    //! while a packet waits other sessions of the thread run and allocate, only fully buffered packets are measured
+                    if ( !m_readSuspended )
+                    {
+                        ++m_bufferedPacketsCount;
+                        m_bufferedPacketAllocations += AllocationCounter::GetThreadCount() - allocations;
+                    }
+#endif
+
+                    if ( !handled )
+                        break;
+                }
+            }
+            catch ( const boost::system::system_error & error )
+            {
+                //! aborted read means the socket was closed by the writer or destroyed by its owner, it must not be touched anymore
+                if ( error.code() == boost::asio::error::operation_aborted || lifetime.expired() )
+                    co_return;
+            }
+
+            Disconnect();
+        }
+
+        //! Same as the reader, the owner may be gone by the first step or by the time a write completes
+        boost::asio::awaitable<void> SocketWriterAsync( std::weak_ptr< void > lifetime )
+        {
+            if ( lifetime.expired() )
+                co_return;
+
+            std::vector< ByteBuffer > pending;
+            std::vector< boost::asio::const_buffer > buffers;
+
+            try
+            {
+                for ( ;; )
+                {
+                    while ( !m_outgoing.empty() )
+                    {
+                        pending.push_back( std::move( m_outgoing.front() ) );
+                        m_outgoing.pop_front();
+
+                        buffers.push_back( boost::asio::buffer( pending.back().m_data ) );
+                    }
+
+                    if ( pending.empty() )
+                    {
+                        m_writing = false;
+                        co_return;
+                    }
+
+                    const size_t bytesSent = co_await boost::asio::async_write( m_socket, buffers, boost::asio::use_awaitable );
+                    if ( lifetime.expired() )
+                        co_return;
+
+                    m_outgoingSize -= bytesSent;
+
+                    //! sent packets are mostly built from the pool, their storage is recycled for the next ones
+                    auto & pool = BufferPool::GetThreadPool();
+                    for ( auto & sent : pending )
+                        pool.Release( sent );
+
+                    pending.clear();
+                    buffers.clear();
+                }
+            }
+            catch ( const boost::system::system_error & error )
+            {
+                //! a failed write of a destroyed session must not disconnect and wake its former owner
+                if ( lifetime.expired() )
+                    co_return;
+
+                //! nothing queued can go out anymore, a later SendBuffer must not wait on a writer that is gone
+                m_outgoing.clear();
+                m_outgoingSize = 0u;
+                m_writing = false;
+
+                if ( error.code() == boost::asio::error::operation_aborted )
+                    co_return;
+            }
+
+            Disconnect();
+        }
+
         std::array< std::byte, BUFFER_SIZE >        m_buffer;
-        boost::concurrent::sync_deque< ByteBuffer > m_outgoing;
+        size_t                                      m_readOffset;
+        size_t                                      m_writeOffset;
+#if defined( HEADLESSY_ALLOCATION_STATS )
+        bool                                        m_readSuspended = false;
+        size_t                                      m_bufferedPacketsCount = 0u;
+        uint64_t                                    m_bufferedPacketAllocations = 0u;
+#endif
+        std::deque< ByteBuffer >                    m_outgoing;
+        size_t                                      m_outgoingSize;
+        bool                                        m_writing;
+        std::atomic< bool >                         m_connected;
+        bool                                        m_connecting;
+        size_t                                      m_highWaterMark;
+        HighWaterPolicy                             m_highWaterPolicy;
 
         boost::asio::io_context &                   m_context;
         boost::asio::ip::tcp::socket                m_socket;
+        NotifyHandler                               m_notifyHandler;
+        std::shared_ptr< void >                     m_lifetime;
     };
 }
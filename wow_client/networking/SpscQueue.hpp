@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace Network
+{
+    //! Bounded lock-free queue for exactly one producer and one consumer thread
+    template< typename T, size_t CAPACITY >
+    class SpscQueue
+    {
+        static_assert( CAPACITY != 0 && ( CAPACITY & ( CAPACITY - 1 ) ) == 0, "ERROR: capacity must be a power of two!" );
+
+    public:
+        SpscQueue()
+            : m_head( 0u )
+            , m_tail( 0u )
+        {
+        }
+
+        //! Producer side, `value` is left untouched when the queue is full
+        template< typename U >
+        bool TryPush( U && value )
+        {
+            const size_t tail = m_tail.load( std::memory_order_relaxed );
+            if ( tail - m_head.load( std::memory_order_acquire ) == CAPACITY )
+                return false;
+
+            m_slots[ tail & ( CAPACITY - 1 ) ] = std::forward< U >( value );
+            m_tail.store( tail + 1, std::memory_order_release );
+            return true;
+        }
+
+        //! Consumer side, hands every queued element to `handler`, resets it and releases the slots in one go
+        template< typename Handler >
+        size_t Drain( Handler && handler )
+        {
+            const size_t head = m_head.load( std::memory_order_relaxed );
+            const size_t tail = m_tail.load( std::memory_order_acquire );
+
+            for ( size_t idx = head; idx != tail; ++idx )
+            {
+                T & slot = m_slots[ idx & ( CAPACITY - 1 ) ];
+                handler( slot );
+
+                //! whatever the handler left in the slot, a handle or a buffer, is released now and not when the slot is reused
+                slot = T{};
+            }
+
+            m_head.store( tail, std::memory_order_release );
+            return tail - head;
+        }
+
+        //! Queue depth gauge, exact only when read from the producer or consumer thread
+        size_t GetSize() const
+        {
+            return m_tail.load( std::memory_order_acquire ) - m_head.load( std::memory_order_acquire );
+        }
+
+        static constexpr size_t GetCapacity()
+        {
+            return CAPACITY;
+        }
+
+    private:
+        alignas( 64 ) std::atomic< size_t > m_head;
+        alignas( 64 ) std::atomic< size_t > m_tail;
+        std::array< T, CAPACITY >           m_slots;
+    };
+}